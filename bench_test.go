@@ -0,0 +1,146 @@
+package tf2lzham
+
+import (
+	"bytes"
+	"fmt"
+	"testing"
+)
+
+// The benchmarks run Compress and Decompress for each backend over the
+// generated corpus (see corpus_test.go), as Benchmark{Compress,Decompress}/
+// backend/input, and CompressLevel and CompressParallel with a few levels and
+// chunk sizes for the backends which support them. In addition to ns/op, MB/s,
+// B/op, and allocs/op, compression benchmarks report the compressed size as a
+// fraction of the input (ratio), so results from different releases can be
+// compared with benchstat.
+
+// backend is a Compress/Decompress implementation to benchmark.
+type backend struct {
+	Name       string
+	Compress   func(dst, src []byte) (n int, adler32, crc32 uint32, err error)
+	Decompress func(dst, src []byte) (n int, adler32, crc32 uint32, err error)
+
+	// Levels and CompressParallel are nil if the backend doesn't support them.
+	Levels           []benchLevel
+	CompressParallel func(dst, src []byte, chunkSize, workers int) (n int, adler32, crc32 uint32, err error)
+}
+
+// benchLevel is CompressLevel with a specific level. The backends compare the
+// greedy, fastest, and uber levels (Compress uses uber with deterministic
+// parsing).
+type benchLevel struct {
+	Name     string
+	Compress func(dst, src []byte) (n int, adler32, crc32 uint32, err error)
+}
+
+// backends contains the cgo (if enabled) and wasm backends.
+var backends []backend
+
+func BenchmarkCompress(b *testing.B) {
+	for _, be := range backends {
+		for _, e := range corpus() {
+			b.Run(be.Name+"/"+e.Name, func(b *testing.B) {
+				benchCompress(b, e.Data, be.Compress)
+			})
+		}
+	}
+}
+
+// benchCompress runs compress on data, reporting the ratio of the last call.
+func benchCompress(b *testing.B, data []byte, compress func(dst, src []byte) (n int, adler32, crc32 uint32, err error)) int {
+	dst := make([]byte, len(data)+len(data)/2+64)
+	b.SetBytes(int64(len(data)))
+	b.ReportAllocs()
+	b.ResetTimer()
+	var n int
+	for i := 0; i < b.N; i++ {
+		var err error
+		if n, _, _, err = compress(dst, data); err != nil {
+			b.Fatal(err)
+		}
+	}
+	b.ReportMetric(float64(n)/float64(len(data)), "ratio")
+	return n
+}
+
+// BenchmarkCompressLevel runs CompressLevel for each backend, level, and input
+// as BenchmarkCompressLevel/backend/level/input.
+func BenchmarkCompressLevel(b *testing.B) {
+	for _, be := range backends {
+		for _, l := range be.Levels {
+			for _, e := range corpus() {
+				b.Run(be.Name+"/"+l.Name+"/"+e.Name, func(b *testing.B) {
+					benchCompress(b, e.Data, l.Compress)
+				})
+			}
+		}
+	}
+}
+
+// BenchmarkCompressParallel runs CompressParallel for each backend, chunk
+// size, worker count, and input larger than a chunk as
+// BenchmarkCompressParallel/backend/chunk-workers/input. In addition to the
+// ratio, it reports the fraction by which the output is larger than Compress
+// (loss), to compare with the speedup over BenchmarkCompress.
+func BenchmarkCompressParallel(b *testing.B) {
+	for _, be := range backends {
+		if be.CompressParallel == nil {
+			continue
+		}
+		for _, chunkSize := range []int{512 << 10, 2 << 20} {
+			for _, workers := range []int{2, 4, 0} {
+				for _, e := range corpus() {
+					if len(e.Data) <= chunkSize {
+						continue
+					}
+					name := fmt.Sprintf("%s/%s-%d/%s", be.Name, sizeName(chunkSize), workers, e.Name)
+					if workers == 0 {
+						name = fmt.Sprintf("%s/%s-max/%s", be.Name, sizeName(chunkSize), e.Name)
+					}
+					b.Run(name, func(b *testing.B) {
+						ref := make([]byte, len(e.Data)+len(e.Data)/2+64)
+						m, _, _, err := be.Compress(ref, e.Data)
+						if err != nil {
+							b.Fatalf("compress: %v", err)
+						}
+						n := benchCompress(b, e.Data, func(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+							return be.CompressParallel(dst, src, chunkSize, workers)
+						})
+						b.ReportMetric(float64(n)/float64(m)-1, "loss")
+					})
+				}
+			}
+		}
+	}
+}
+
+func BenchmarkDecompress(b *testing.B) {
+	for _, be := range backends {
+		for _, e := range corpus() {
+			b.Run(be.Name+"/"+e.Name, func(b *testing.B) {
+				comp := make([]byte, len(e.Data)+len(e.Data)/2+64)
+				n, _, _, err := be.Compress(comp, e.Data)
+				if err != nil {
+					b.Fatalf("compress: %v", err)
+				}
+				comp = comp[:n]
+
+				dst := make([]byte, len(e.Data))
+				if n, _, _, err := be.Decompress(dst, comp); err != nil {
+					b.Fatalf("decompress: %v", err)
+				} else if !bytes.Equal(dst[:n], e.Data) {
+					b.Fatalf("decompressed output does not match input")
+				}
+
+				b.SetBytes(int64(len(e.Data)))
+				b.ReportAllocs()
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					if _, _, _, err := be.Decompress(dst, comp); err != nil {
+						b.Fatal(err)
+					}
+				}
+			})
+		}
+	}
+}
@@ -0,0 +1,143 @@
+package tf2lzham
+
+import (
+	"container/list"
+	"errors"
+	"hash/maphash"
+	"sync"
+)
+
+// Cache is a bounded LRU cache of Compress results, for servers which
+// repeatedly compress identical buffers. Since Compress uses deterministic
+// parsing, the output only depends on the input, so a hit returns the stored
+// output without compressing it again. It is safe for concurrent use.
+//
+// Entries are keyed by a 64-bit hash of the input (with a random seed for each
+// cache) and its length.
+type Cache struct {
+	seed     maphash.Seed
+	maxBytes int64
+
+	mu      sync.Mutex
+	entries map[cacheKey]*list.Element
+	lru     list.List // of *cacheEntry, most recently used first
+	stats   CacheStats
+}
+
+// CacheStats contains counters for sizing a Cache.
+type CacheStats struct {
+	Hits      uint64
+	Misses    uint64
+	Evictions uint64
+	Entries   int
+	Bytes     int64 // compressed bytes held
+	MaxBytes  int64
+}
+
+// HitRate returns the fraction of lookups which were hits.
+func (s CacheStats) HitRate() float64 {
+	if n := s.Hits + s.Misses; n != 0 {
+		return float64(s.Hits) / float64(n)
+	}
+	return 0
+}
+
+type cacheKey struct {
+	hash uint64
+	len  int
+}
+
+type cacheEntry struct {
+	key     cacheKey
+	buf     []byte
+	adler32 uint32
+	crc32   uint32
+}
+
+// NewCache returns a Cache holding up to maxBytes of compressed output.
+func NewCache(maxBytes int64) *Cache {
+	c := &Cache{
+		seed:     maphash.MakeSeed(),
+		maxBytes: maxBytes,
+		entries:  map[cacheKey]*list.Element{},
+	}
+	c.stats.MaxBytes = maxBytes
+	return c
+}
+
+// Compress is like the package-level Compress function, but returns the cached
+// output if src has been compressed before.
+func (c *Cache) Compress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+	if len(dst) == 0 || len(src) == 0 {
+		return 0, 0, 0, errors.New("lzham: zero-length buffer")
+	}
+	k := cacheKey{maphash.Bytes(c.seed, src), len(src)}
+
+	c.mu.Lock()
+	if el, ok := c.entries[k]; ok {
+		e := el.Value.(*cacheEntry)
+		c.lru.MoveToFront(el)
+		c.stats.Hits++
+		c.mu.Unlock()
+		if len(e.buf) > len(dst) {
+			return 0, 0, 0, errors.New("lzham: output buffer too small")
+		}
+		return copy(dst, e.buf), e.adler32, e.crc32, nil
+	}
+	c.stats.Misses++
+	c.mu.Unlock()
+
+	if n, adler32, crc32, err = Compress(dst, src); err == nil {
+		c.add(&cacheEntry{
+			key:     k,
+			buf:     append([]byte(nil), dst[:n]...),
+			adler32: adler32,
+			crc32:   crc32,
+		})
+	}
+	return
+}
+
+// add adds an entry, evicting the least recently used entries to make room.
+func (c *Cache) add(e *cacheEntry) {
+	if int64(len(e.buf)) > c.maxBytes {
+		return
+	}
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	if _, ok := c.entries[e.key]; ok {
+		return // added by a concurrent miss
+	}
+	for c.stats.Bytes+int64(len(e.buf)) > c.maxBytes {
+		c.remove(c.lru.Back())
+		c.stats.Evictions++
+	}
+	c.entries[e.key] = c.lru.PushFront(e)
+	c.stats.Entries++
+	c.stats.Bytes += int64(len(e.buf))
+}
+
+func (c *Cache) remove(el *list.Element) {
+	e := c.lru.Remove(el).(*cacheEntry)
+	delete(c.entries, e.key)
+	c.stats.Entries--
+	c.stats.Bytes -= int64(len(e.buf))
+}
+
+// Stats returns the current counters.
+func (c *Cache) Stats() CacheStats {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return c.stats
+}
+
+// Reset removes all entries and zeroes the counters.
+func (c *Cache) Reset() {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	for el := c.lru.Front(); el != nil; el = c.lru.Front() {
+		c.remove(el)
+	}
+	c.stats = CacheStats{MaxBytes: c.maxBytes}
+}
@@ -0,0 +1,79 @@
+package tf2lzham
+
+import (
+	"bytes"
+	"fmt"
+	"testing"
+)
+
+// testCacheInput generates compressible input which differs for each seed.
+func testCacheInput(n, seed int) []byte {
+	var b []byte
+	for i := 0; len(b) < n; i++ {
+		b = fmt.Appendf(b, "\"mp_weapon_%d\" \"%d\"\n", seed, i%97)
+	}
+	return b[:n]
+}
+
+func TestCache(t *testing.T) {
+	var (
+		src  [3][]byte
+		comp [3][]byte
+	)
+	for i := range src {
+		src[i] = testCacheInput(8<<10, i)
+		comp[i] = make([]byte, len(src[i])+256)
+		n, _, _, err := Compress(comp[i], src[i])
+		if err != nil {
+			t.Fatal(err)
+		}
+		comp[i] = comp[i][:n]
+	}
+
+	check := func(c *Cache, i int, stats CacheStats) {
+		t.Helper()
+		dst := make([]byte, len(src[i])+256)
+		if n, _, _, err := c.Compress(dst, src[i]); err != nil {
+			t.Fatalf("input %d: compress: %v", i, err)
+		} else if !bytes.Equal(dst[:n], comp[i]) {
+			t.Fatalf("input %d: output differs from Compress", i)
+		}
+		if s := c.Stats(); s != stats {
+			t.Fatalf("input %d: expected stats %+v, got %+v", i, stats, s)
+		}
+	}
+
+	// room for the first two
+	maxBytes := int64(len(comp[0]) + len(comp[1]))
+	c := NewCache(maxBytes)
+	check(c, 0, CacheStats{Misses: 1, Entries: 1, Bytes: int64(len(comp[0])), MaxBytes: maxBytes})
+	check(c, 1, CacheStats{Misses: 2, Entries: 2, Bytes: maxBytes, MaxBytes: maxBytes})
+	check(c, 0, CacheStats{Hits: 1, Misses: 2, Entries: 2, Bytes: maxBytes, MaxBytes: maxBytes})
+
+	// evicts the least recently used (1), then 0 is still cached
+	size := int64(len(comp[0]) + len(comp[2]))
+	check(c, 2, CacheStats{Hits: 1, Misses: 3, Evictions: 1, Entries: 2, Bytes: size, MaxBytes: maxBytes})
+	check(c, 0, CacheStats{Hits: 2, Misses: 3, Evictions: 1, Entries: 2, Bytes: size, MaxBytes: maxBytes})
+	if r := c.Stats().HitRate(); r != 0.4 {
+		t.Errorf("expected hit rate 0.4, got %f", r)
+	}
+
+	// a hit still needs a large enough buffer
+	if _, _, _, err := c.Compress(make([]byte, len(comp[0])-1), src[0]); err == nil {
+		t.Errorf("expected error for a small output buffer")
+	}
+	if _, _, _, err := c.Compress(nil, src[0]); err == nil {
+		t.Errorf("expected error for a zero-length buffer")
+	}
+
+	c.Reset()
+	if s := c.Stats(); s != (CacheStats{MaxBytes: maxBytes}) {
+		t.Errorf("expected empty stats after reset, got %+v", s)
+	}
+	check(c, 0, CacheStats{Misses: 1, Entries: 1, Bytes: int64(len(comp[0])), MaxBytes: maxBytes})
+
+	// entries larger than the cache aren't stored
+	c = NewCache(int64(len(comp[0]) - 1))
+	check(c, 0, CacheStats{Misses: 1, MaxBytes: int64(len(comp[0]) - 1)})
+	check(c, 0, CacheStats{Misses: 2, MaxBytes: int64(len(comp[0]) - 1)})
+}
@@ -0,0 +1,163 @@
+package tf2lzham
+
+import (
+	"bytes"
+	"errors"
+	"fmt"
+	"io"
+	"testing"
+)
+
+// checkArena checks that the first call on a context took nearly all of its
+// memory from the context's arena (i.e., a few chunks), and that the later ones
+// (which reuse the context) didn't allocate anything.
+func checkArena(stats func() (Stats, error), first bool) error {
+	s, err := stats()
+	if err != nil {
+		return err
+	}
+	if first {
+		if s.Allocs == 0 {
+			return errors.New("expected the first call to allocate")
+		}
+		if s.UnderlyingAllocs*10 > s.Allocs {
+			return fmt.Errorf("%d of %d allocations reached the C allocator", s.UnderlyingAllocs, s.Allocs)
+		}
+	} else if s.Allocs != 0 || s.UnderlyingAllocs != 0 || s.BytesAllocated != 0 {
+		return fmt.Errorf("made %d allocations (%d from the C allocator, %d bytes) after reuse", s.Allocs, s.UnderlyingAllocs, s.BytesAllocated)
+	}
+	return nil
+}
+
+// A reused compressor or decompressor takes all of its memory from its arena,
+// so it shouldn't allocate anything after the first call.
+func TestArena(t *testing.T) {
+	c, err := NewCompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer c.Close()
+	d, err := NewDecompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer d.Close()
+
+	big, small := testRecords(300<<10, 1), testRecords(4<<10, 2)
+	for i, src := range [][]byte{big, small, big, testRandom(64<<10, 3), big} {
+		comp := make([]byte, compressBound(len(src)))
+		n, _, _, err := c.Compress(comp, src)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if err := checkArena(c.Stats, i == 0); err != nil {
+			t.Errorf("compress %d: %v", i, err)
+		}
+		checkDecompress(t, comp[:n], src)
+
+		dst := make([]byte, len(src))
+		if _, _, _, err := d.Decompress(dst, comp[:n]); err != nil {
+			t.Fatal(err)
+		} else if !bytes.Equal(dst, src) {
+			t.Fatalf("decompress %d: output does not match input", i)
+		}
+		if err := checkArena(d.Stats, i == 0); err != nil {
+			t.Errorf("decompress %d: %v", i, err)
+		}
+	}
+}
+
+func TestArenaStream(t *testing.T) {
+	src := testRecords(300<<10, 1)
+
+	var buf bytes.Buffer
+	w, err := NewWriter(&buf)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer w.Close()
+	r, err := NewReader(&buf)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer r.Close()
+
+	for i := 0; i < 3; i++ {
+		buf.Reset()
+		if err := w.Reset(&buf); err != nil {
+			t.Fatal(err)
+		}
+		if _, err := w.Write(src); err != nil {
+			t.Fatal(err)
+		}
+		if err := w.Flush(); err != nil {
+			t.Fatal(err)
+		}
+		if err := checkArena(w.Stats, i == 0); err != nil {
+			t.Errorf("stream %d: writer %v", i, err)
+		}
+
+		if err := r.Reset(bytes.NewReader(buf.Bytes())); err != nil {
+			t.Fatal(err)
+		}
+		dec := make([]byte, len(src))
+		if _, err := io.ReadFull(r, dec); err != nil {
+			t.Fatal(err)
+		} else if !bytes.Equal(dec, src) {
+			t.Fatalf("stream %d: read output does not match input", i)
+		}
+		if err := checkArena(r.Stats, i == 0); err != nil {
+			t.Errorf("stream %d: reader %v", i, err)
+		}
+	}
+}
+
+// Each compressor and decompressor has its own arena, and helper threads use
+// the arena of the compressor which queued the task, so contexts used
+// concurrently mustn't interfere.
+func TestArenaConcurrent(t *testing.T) {
+	errs := make(chan error, 8)
+	for g := 0; g < cap(errs); g++ {
+		go func(g int) {
+			errs <- func() error {
+				c, err := NewCompressor()
+				if err != nil {
+					return err
+				}
+				defer c.Close()
+				d, err := NewDecompressor()
+				if err != nil {
+					return err
+				}
+				defer d.Close()
+				for i := 0; i < 3; i++ {
+					src := testRecords(64<<10+g*1000, int64(g*3+i))
+					comp := make([]byte, compressBound(len(src)))
+					n, _, _, err := c.Compress(comp, src)
+					if err != nil {
+						return err
+					}
+					if err := checkArena(c.Stats, i == 0); err != nil {
+						return fmt.Errorf("compress %d: %w", i, err)
+					}
+					dst := make([]byte, len(src))
+					if _, _, _, err := d.Decompress(dst, comp[:n]); err != nil {
+						return err
+					}
+					if err := checkArena(d.Stats, i == 0); err != nil {
+						return fmt.Errorf("decompress %d: %w", i, err)
+					}
+					if !bytes.Equal(dst, src) {
+						return errors.New("decompressed output does not match input")
+					}
+				}
+				return nil
+			}()
+		}(g)
+	}
+	for i := 0; i < cap(errs); i++ {
+		if err := <-errs; err != nil {
+			t.Error(err)
+		}
+	}
+}
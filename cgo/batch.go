@@ -0,0 +1,140 @@
+package tf2lzham
+
+// #include "tf2lzham.h"
+import "C"
+
+import (
+	"errors"
+	"runtime"
+	"unsafe"
+)
+
+// BatchResult is the result of compressing or decompressing a single buffer in
+// a batch.
+type BatchResult struct {
+	N       int
+	Adler32 uint32
+	CRC32   uint32
+	Err     error
+}
+
+// CompressBatch compresses each src[i] into dst[i]. It is equivalent to calling
+// Compress for each buffer, but uses a single compressor and crosses into C
+// once for the whole batch, which is much faster for many small buffers. An
+// error is only returned if the batch itself is invalid; errors for individual
+// buffers are returned in the results.
+func CompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	if c, _ := compressorPool.Get().(*Compressor); c != nil {
+		defer compressorPool.Put(c)
+		return c.CompressBatch(dst, src)
+	}
+	c, err := NewCompressor()
+	if err != nil {
+		return nil, err
+	}
+	defer c.Close()
+	return c.CompressBatch(dst, src)
+}
+
+// CompressBatch is like the package-level CompressBatch function, but uses the
+// provided compressor.
+func (c *Compressor) CompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	if c.c == nil {
+		return nil, errors.New("lzham: compressor closed")
+	}
+	if len(dst) != len(src) {
+		return nil, errors.New("lzham: mismatched batch length")
+	}
+	if len(src) == 0 {
+		return nil, nil
+	}
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+
+	items := batchItems(&pinner, dst, src)
+	C.tf2lzham_compressor_compress_batch(c.c, &items[0], C.size_t(len(items)))
+	return batchResults(items, false), nil
+}
+
+// DecompressBatch decompresses each src[i] into dst[i]. It is equivalent to
+// calling Decompress for each buffer, but uses a single decompressor and
+// crosses into C once for the whole batch. An error is only returned if the
+// batch itself is invalid; errors for individual buffers are returned in the
+// results.
+func DecompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	if d, _ := decompressorPool.Get().(*Decompressor); d != nil {
+		defer decompressorPool.Put(d)
+		return d.DecompressBatch(dst, src)
+	}
+	d, err := NewDecompressor()
+	if err != nil {
+		return nil, err
+	}
+	defer d.Close()
+	return d.DecompressBatch(dst, src)
+}
+
+// DecompressBatch is like the package-level DecompressBatch function, but uses
+// the provided decompressor.
+func (d *Decompressor) DecompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	if d.d == nil {
+		return nil, errors.New("lzham: decompressor closed")
+	}
+	if len(dst) != len(src) {
+		return nil, errors.New("lzham: mismatched batch length")
+	}
+	if len(src) == 0 {
+		return nil, nil
+	}
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+
+	items := batchItems(&pinner, dst, src)
+	C.tf2lzham_decompressor_decompress_batch(d.d, &items[0], C.size_t(len(items)))
+	return batchResults(items, true), nil
+}
+
+// batchItems pins the buffers and builds the items for a batch. Items for
+// zero-length buffers have nil pointers.
+func batchItems(pinner *runtime.Pinner, dst, src [][]byte) []C.tf2lzham_batch_item {
+	items := make([]C.tf2lzham_batch_item, len(src))
+	for i := range items {
+		if len(dst[i]) == 0 || len(src[i]) == 0 {
+			continue
+		}
+		pinner.Pin(&dst[i][0])
+		pinner.Pin(&src[i][0])
+		items[i] = C.tf2lzham_batch_item{
+			dst:     (*C.uint8_t)(unsafe.Pointer(&dst[i][0])),
+			dst_len: C.size_t(len(dst[i])),
+			src:     (*C.uint8_t)(unsafe.Pointer(&src[i][0])),
+			src_len: C.size_t(len(src[i])),
+		}
+	}
+	return items
+}
+
+// batchResults converts the items from a completed batch into results.
+func batchResults(items []C.tf2lzham_batch_item, decompress bool) []BatchResult {
+	res := make([]BatchResult, len(items))
+	for i, it := range items {
+		var _err *C.char
+		if decompress {
+			_err = C.tf2lzham_decompress_strerror(it.status)
+		} else {
+			_err = C.tf2lzham_compress_strerror(it.status)
+		}
+		if it.dst == nil {
+			res[i].Err = errors.New("lzham: zero-length buffer")
+		} else if _err != nil {
+			res[i].Err = errors.New("lzham: " + C.GoString(_err))
+		} else {
+			res[i] = BatchResult{
+				N:       int(it.dst_len),
+				Adler32: uint32(it.adler32),
+				CRC32:   uint32(it.crc32),
+			}
+		}
+	}
+	return res
+}
@@ -0,0 +1,131 @@
+package tf2lzham
+
+import (
+	"bytes"
+	"hash/adler32"
+	"testing"
+)
+
+func TestCompressBatch(t *testing.T) {
+	var dst, src [][]byte
+	for _, in := range testInputs() {
+		dst = append(dst, make([]byte, compressBound(len(in.data))))
+		src = append(src, in.data)
+	}
+	// errors are per buffer
+	small, empty := len(src), len(src)+1
+	dst = append(dst, make([]byte, 16), make([]byte, 16))
+	src = append(src, testRecords(4<<10, 1), nil)
+
+	res, err := CompressBatch(dst, src)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(res) != len(src) {
+		t.Fatalf("expected %d results, got %d", len(src), len(res))
+	}
+	for i, r := range res {
+		if i == small || i == empty {
+			if r.Err == nil {
+				t.Errorf("item %d: expected error", i)
+			}
+			continue
+		}
+		if r.Err != nil {
+			t.Fatalf("item %d: compress: %v", i, r.Err)
+		}
+		if exp := adler32.Checksum(src[i]); r.Adler32 != exp {
+			t.Errorf("item %d: adler32 %08x, expected %08x", i, r.Adler32, exp)
+		}
+
+		// same as Compress
+		ref := make([]byte, compressBound(len(src[i])))
+		if n, _, _, err := Compress(ref, src[i]); err != nil {
+			t.Fatalf("item %d: compress: %v", i, err)
+		} else if !bytes.Equal(dst[i][:r.N], ref[:n]) {
+			t.Errorf("item %d: output differs from Compress", i)
+		}
+		checkDecompress(t, dst[i][:r.N], src[i])
+	}
+
+	if _, err := CompressBatch(dst[:1], src); err == nil {
+		t.Errorf("expected error for mismatched batch length")
+	}
+	if res, err := CompressBatch(nil, nil); err != nil || len(res) != 0 {
+		t.Errorf("expected no results for an empty batch, got %d %v", len(res), err)
+	}
+
+	c, err := NewCompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	c.Close()
+	if _, err := c.CompressBatch(dst, src); err == nil {
+		t.Errorf("expected error for a closed compressor")
+	}
+}
+
+func TestDecompressBatch(t *testing.T) {
+	var dst, src, exp [][]byte
+	for _, in := range testInputs() {
+		comp := make([]byte, compressBound(len(in.data)))
+		n, _, _, err := Compress(comp, in.data)
+		if err != nil {
+			t.Fatalf("%s: compress: %v", in.name, err)
+		}
+		dst = append(dst, make([]byte, len(in.data)))
+		src = append(src, comp[:n])
+		exp = append(exp, in.data)
+	}
+	// errors are per buffer, and don't affect the following items
+	corrupt := append([]byte(nil), src[len(src)-1]...)
+	corrupt[len(corrupt)/2] ^= 0xFF
+	bad := len(src) // small dst, truncated, corrupted, zero-length dst
+	dst = append(dst, make([]byte, len(exp[4])-1), make([]byte, len(exp[4])), make([]byte, len(exp[len(exp)-1])), nil)
+	src = append(src, src[4], src[4][:len(src[4])/2], corrupt, src[0])
+	exp = append(exp, nil, nil, nil, nil)
+	dst = append(dst, make([]byte, len(exp[3])))
+	src = append(src, src[3])
+	exp = append(exp, exp[3])
+
+	res, err := DecompressBatch(dst, src)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(res) != len(src) {
+		t.Fatalf("expected %d results, got %d", len(src), len(res))
+	}
+	for i, r := range res {
+		if i >= bad && i < bad+4 {
+			if r.Err == nil {
+				t.Errorf("item %d: expected error", i)
+			}
+			continue
+		}
+		if r.Err != nil {
+			t.Fatalf("item %d: decompress: %v", i, r.Err)
+		}
+		if !bytes.Equal(dst[i][:r.N], exp[i]) {
+			t.Errorf("item %d: decompressed output does not match input", i)
+		}
+		if e := adler32.Checksum(exp[i]); r.Adler32 != e {
+			t.Errorf("item %d: adler32 %08x, expected %08x", i, r.Adler32, e)
+		}
+	}
+
+	if _, err := DecompressBatch(dst[:1], src); err == nil {
+		t.Errorf("expected error for mismatched batch length")
+	}
+	if res, err := DecompressBatch(nil, nil); err != nil || len(res) != 0 {
+		t.Errorf("expected no results for an empty batch, got %d %v", len(res), err)
+	}
+
+	d, err := NewDecompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	d.Close()
+	if _, err := d.DecompressBatch(dst, src); err == nil {
+		t.Errorf("expected error for a closed decompressor")
+	}
+}
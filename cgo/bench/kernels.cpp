@@ -0,0 +1,380 @@
+// File: kernels.cpp
+// Microbenchmarks for the codec kernels, each driven in isolation with fixed inputs so kernel changes can be
+// evaluated without going through Go. Reports the best time per byte (or per symbol, for code generation) in TSC
+// cycles on x86, or nanoseconds elsewhere.
+//
+// Build and run from this directory:
+//    c++ -O2 -std=c++11 -DLZHAM_ANSI_CPLUSPLUS -DNDEBUG -I.. -o kernels kernels.cpp ../*.cpp -lpthread && ./kernels
+//
+// An optional argument only runs the kernels whose names contain it (e.g. ./kernels huffman).
+//
+// The checksum kernels are checked against a bytewise Adler-32 and CRC-32 before they're timed. To check and time the wasm SIMD128
+// paths, build it with the wasi-sdk $CXX and -msimd128 instead, and run it with a WASI runtime.
+#include "lzham_core.h"
+#include "lzham_checksum.h"
+#include "lzham_huffman_codes.h"
+#include "lzham_polar_codes.h"
+#include "lzham_prefix_coding.h"
+#include "lzham_match_accel.h"
+#include "tf2lzham.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+// The compiler barriers keep the measured work from being moved across the reads.
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static const char* const g_unit = "cycles";
+static inline lzham::uint64 ticks()
+{
+   __asm__ __volatile__("" ::: "memory");
+   lzham::uint64 t = __rdtsc();
+   __asm__ __volatile__("" ::: "memory");
+   return t;
+}
+#else
+static const char* const g_unit = "ns";
+static inline lzham::uint64 ticks()
+{
+   struct timespec ts;
+   __asm__ __volatile__("" ::: "memory");
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   __asm__ __volatile__("" ::: "memory");
+   return static_cast<lzham::uint64>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+using namespace lzham;
+
+namespace
+{
+   const uint cBufSize = 1U << 20;
+   const uint cDictSizeLog2 = 20; // same as TF2
+   const uint cBlockSize = (1U << cDictSizeLog2) / 8;
+
+   const char* g_pFilter;
+
+   // Returns a reproducible buffer of the specified kind: text-like records (kind 0) or structured binary with runs of
+   // zeros (kind 1).
+   std::vector<uint8> make_input(uint kind, uint size)
+   {
+      static const char* const s_words[] = { "pilot", "titan", "loadout", "mp_weapon_r97", "mp_weapon_wingman", "xp", "gen", "faction" };
+      std::vector<uint8> buf;
+      buf.reserve(size + 64);
+      uint32 x = 12345 + kind;
+      while (buf.size() < size)
+      {
+         x = x * 1103515245 + 12345;
+         if (!kind)
+         {
+            char line[64];
+            int n = snprintf(line, sizeof(line), "\"%s\" \"%u\"\n", s_words[(x >> 16) & 7], (x >> 8) & 0xFFFF);
+            buf.insert(buf.end(), line, line + n);
+         }
+         else if (((x >> 16) & 7) == 0)
+            buf.insert(buf.end(), (x >> 20) & 255, 0);
+         else
+         {
+            for (uint i = 0; i < 16; i++)
+               buf.push_back(static_cast<uint8>((x >> (i & 15)) & ((i & 3) ? 0x0F : 0xFF)));
+         }
+      }
+      buf.resize(size);
+      return buf;
+   }
+
+   // Runs fn until at least 200ms have passed (and at least 3 times), and returns the fastest run.
+   template<typename F> uint64 best_of(F fn)
+   {
+      uint64 best = UINT64_MAX;
+      struct timespec start, now;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (uint i = 0; ; i++)
+      {
+         uint64 t = ticks();
+         fn();
+         t = ticks() - t;
+         if (t < best)
+            best = t;
+
+         clock_gettime(CLOCK_MONOTONIC, &now);
+         if ((i >= 2) && ((now.tv_sec - start.tv_sec) * 1000000000LL + (now.tv_nsec - start.tv_nsec) >= 200000000LL))
+            break;
+      }
+      return best;
+   }
+
+   bool enabled(const char* pName)
+   {
+      return !g_pFilter || strstr(pName, g_pFilter);
+   }
+
+   void report(const char* pName, const char* pInput, uint64 t, uint n, const char* pPer)
+   {
+      printf("%-28s %-8s %10.3f %s/%s\n", pName, pInput, static_cast<double>(t) / n, g_unit, pPer);
+   }
+
+   volatile uint g_sink;
+
+   uint adler32_bytewise(const uint8* pBuf, size_t n, uint adler)
+   {
+      uint s1 = adler & 0xFFFF, s2 = adler >> 16;
+      for (size_t i = 0; i < n; i++)
+      {
+         s1 = (s1 + pBuf[i]) % 65521;
+         s2 = (s2 + s1) % 65521;
+      }
+      return (s2 << 16) | s1;
+   }
+
+   // Checks adler32 against adler32_bytewise for lengths around the SIMD block and reduction sizes, at unaligned offsets
+   // and with a non-initial seed.
+   bool check_adler32(const std::vector<uint8>& buf)
+   {
+      static const uint s_lens[] = { 0, 1, 31, 32, 63, 64, 65, 95, 96, 5551, 5552, 5553, 5600, 11104, 11200, 65536 + 33 };
+      for (uint i = 0; i < LZHAM_ARRAY_SIZE(s_lens); i++)
+      {
+         for (uint ofs = 0; ofs < 4; ofs++)
+         {
+            const uint seed = ofs ? 0xFFF0FFF0 : cInitAdler32;
+            if (adler32(&buf[ofs], s_lens[i], seed) != adler32_bytewise(&buf[ofs], s_lens[i], seed))
+            {
+               printf("adler32: mismatch for %u bytes at offset %u\n", s_lens[i], ofs);
+               return false;
+            }
+         }
+      }
+      return true;
+   }
+
+   uint crc32_bytewise(const uint8* pBuf, size_t n, uint crc)
+   {
+      crc = ~crc;
+      for (size_t i = 0; i < n; i++)
+      {
+         crc ^= pBuf[i];
+         for (uint j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0U - (crc & 1)));
+      }
+      return ~crc;
+   }
+
+   // Checks crc32 against crc32_bytewise for lengths around the slice-by-8 and PCLMULQDQ fold sizes (with every tail
+   // length after the folded part), at unaligned offsets and with a non-initial seed.
+   bool check_crc32(const std::vector<uint8>& buf)
+   {
+      static const uint s_lens[] = { 0, 1, 7, 8, 9, 15, 16, 17, 63, 64, 65, 79, 80, 81, 127, 128, 129, 143, 191, 192, 193, 255, 8191, 8192, 8193, 65536 + 33 };
+      for (uint i = 0; i < LZHAM_ARRAY_SIZE(s_lens); i++)
+      {
+         for (uint ofs = 0; ofs < 8; ofs++)
+         {
+            const uint seed = (ofs & 1) ? 0xDEADBEEF : cInitCRC32;
+            if (crc32(seed, &buf[ofs], s_lens[i]) != crc32_bytewise(&buf[ofs], s_lens[i], seed))
+            {
+               printf("crc32: mismatch for %u bytes at offset %u\n", s_lens[i], ofs);
+               return false;
+            }
+         }
+      }
+      return true;
+   }
+
+   // Checks adler32_crc32 against the separate checksums, and crc32_combine against crc32 over the concatenation, for
+   // lengths around the chunk size and splits on both sides of it.
+   bool check_adler32_crc32(const std::vector<uint8>& buf)
+   {
+      static const uint s_lens[] = { 0, 1, 64, 8191, 8192, 8193, 3 * 8192 + 5, 65536 + 33 };
+      for (uint i = 0; i < LZHAM_ARRAY_SIZE(s_lens); i++)
+      {
+         const uint n = s_lens[i];
+         uint a = 0xFFF0FFF0, c = 0xDEADBEEF;
+         adler32_crc32(&buf[1], n, &a, &c);
+         if ((a != adler32(&buf[1], n, 0xFFF0FFF0)) || (c != crc32(0xDEADBEEF, &buf[1], n)))
+         {
+            printf("adler32_crc32: mismatch for %u bytes\n", n);
+            return false;
+         }
+
+         const uint splits[] = { 0, 1, n / 2, n - 1, n };
+         for (uint j = 0; j < LZHAM_ARRAY_SIZE(splits); j++)
+         {
+            const uint k = splits[j];
+            if (k > n)
+               continue;
+            const uint crc1 = crc32(0xDEADBEEF, &buf[1], k), crc2 = crc32(cInitCRC32, &buf[1 + k], n - k);
+            if (crc32_combine(crc1, crc2, n - k) != c)
+            {
+               printf("crc32_combine: mismatch for %u bytes split at %u\n", n, k);
+               return false;
+            }
+         }
+      }
+      return true;
+   }
+
+   void bench_checksums(const char* pInput, const std::vector<uint8>& buf)
+   {
+      if (enabled("adler32") && check_adler32(buf))
+         report("adler32", pInput, best_of([&] { g_sink = adler32(&buf[0], buf.size()); }), buf.size(), "byte");
+
+      if (enabled("crc32") && check_crc32(buf))
+         report("crc32", pInput, best_of([&] { g_sink = crc32(cInitCRC32, &buf[0], buf.size()); }), buf.size(), "byte");
+
+      if (enabled("adler32_crc32") && check_adler32_crc32(buf))
+      {
+         report("adler32_crc32", pInput, best_of([&] {
+            uint a = cInitAdler32, c = cInitCRC32;
+            adler32_crc32(&buf[0], buf.size(), &a, &c);
+            g_sink = a ^ c;
+         }), buf.size(), "byte");
+      }
+   }
+
+   // Feeds the buffer to the match finder a block at a time, like the compressor does. max_probes and max_matches are
+   // the DEFAULT and UBER level settings.
+   void bench_find_all_matches(const char* pInput, const std::vector<uint8>& buf)
+   {
+      static const struct { const char* m_pName; uint m_max_probes; uint m_max_matches; } s_levels[] =
+      {
+         { "find_all_matches/default", 16, UINT_MAX },
+         { "find_all_matches/uber", cMatchAccelMaxSupportedProbes, UINT_MAX },
+      };
+
+      for (uint l = 0; l < LZHAM_ARRAY_SIZE(s_levels); l++)
+      {
+         if (!enabled(s_levels[l].m_pName))
+            continue;
+
+         CLZBase lzbase;
+         lzbase.init_position_slots(cDictSizeLog2);
+
+         task_pool pool;
+         search_accelerator accel;
+         if (!accel.init(&lzbase, &pool, 0, 1U << cDictSizeLog2, s_levels[l].m_max_matches, false, s_levels[l].m_max_probes))
+         {
+            printf("%s: init failed\n", s_levels[l].m_pName);
+            continue;
+         }
+
+         report(s_levels[l].m_pName, pInput, best_of([&] {
+            accel.reset();
+            for (uint ofs = 0; ofs < buf.size(); ofs += cBlockSize)
+            {
+               uint n = LZHAM_MIN(cBlockSize, static_cast<uint>(buf.size()) - ofs);
+               if (!accel.add_bytes_begin(n, &buf[ofs]))
+                  return;
+               accel.add_bytes_end();
+               accel.advance_bytes(n);
+            }
+         }), buf.size(), "byte");
+      }
+   }
+
+   // Generates codes for the byte histogram of the input, like the literal tables.
+   void bench_code_generation(const char* pInput, const std::vector<uint8>& buf)
+   {
+      const uint cNumSyms = 256;
+
+      std::vector<uint> hist(cNumSyms);
+      for (size_t i = 0; i < buf.size(); i++)
+         hist[buf[i]]++;
+
+      // The models scale the frequencies to 16 bits.
+      std::vector<uint16> freq(cNumSyms);
+      uint max_hist = 1;
+      for (uint i = 0; i < cNumSyms; i++)
+         max_hist = LZHAM_MAX(max_hist, hist[i]);
+      for (uint i = 0; i < cNumSyms; i++)
+         freq[i] = static_cast<uint16>(hist[i] ? LZHAM_MAX(1U, static_cast<uint>((static_cast<uint64>(hist[i]) * 65535U) / max_hist)) : 0);
+
+      std::vector<uint8> code_sizes(cNumSyms);
+      std::vector<uint16> codes(cNumSyms);
+      uint max_code_size, total_freq;
+
+      if (enabled("generate_huffman_codes"))
+      {
+         std::vector<uint8> context(get_generate_huffman_codes_table_size());
+         report("generate_huffman_codes", pInput, best_of([&] {
+            g_sink = generate_huffman_codes(&context[0], cNumSyms, &freq[0], &code_sizes[0], max_code_size, total_freq);
+         }), cNumSyms, "sym");
+      }
+
+      if (enabled("generate_polar_codes"))
+      {
+         std::vector<uint8> context(get_generate_polar_codes_table_size());
+         report("generate_polar_codes", pInput, best_of([&] {
+            g_sink = generate_polar_codes(&context[0], cNumSyms, &freq[0], &code_sizes[0], max_code_size, total_freq);
+         }), cNumSyms, "sym");
+      }
+
+      if (enabled("generate_decoder_tables"))
+      {
+         std::vector<uint8> context(get_generate_huffman_codes_table_size());
+         generate_huffman_codes(&context[0], cNumSyms, &freq[0], &code_sizes[0], max_code_size, total_freq);
+         prefix_coding::limit_max_code_size(cNumSyms, &code_sizes[0], prefix_coding::cMaxExpectedCodeSize);
+
+         const uint table_bits = math::minimum(1 + math::ceil_log2i(cNumSyms), prefix_coding::cMaxTableBits);
+         prefix_coding::decoder_tables tables;
+         report("generate_decoder_tables", pInput, best_of([&] {
+            g_sink = prefix_coding::generate_decoder_tables(cNumSyms, &code_sizes[0], &tables, table_bits);
+         }), cNumSyms, "sym");
+      }
+   }
+
+   // Decompresses the buffer with the TF2 parameters, reusing a decompressor.
+   void bench_decompress(const char* pInput, const std::vector<uint8>& buf)
+   {
+      if (!enabled("decompress"))
+         return;
+
+      std::vector<uint8> comp(buf.size() + buf.size() / 8 + 1024), out(buf.size());
+      size_t comp_len = comp.size();
+      uint32_t adler32_out, crc32_out;
+      if (tf2lzham_compress_strerror(tf2lzham_compress(&comp[0], &comp_len, &buf[0], buf.size(), &adler32_out, &crc32_out)))
+      {
+         printf("decompress: compress failed\n");
+         return;
+      }
+
+      tf2lzham_decompressor_ptr d = tf2lzham_decompressor_new();
+      if (!d)
+      {
+         printf("decompress: init failed\n");
+         return;
+      }
+
+      bool failed = false;
+      uint64 t = best_of([&] {
+         size_t out_len = out.size();
+         if (tf2lzham_decompress_strerror(tf2lzham_decompressor_decompress(d, &out[0], &out_len, &comp[0], comp_len, &adler32_out, &crc32_out)))
+            failed = true;
+      });
+      tf2lzham_decompressor_free(d);
+
+      if (failed || memcmp(&out[0], &buf[0], buf.size()))
+         printf("decompress: failed\n");
+      else
+         report("decompress", pInput, t, buf.size(), "byte");
+   }
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+   g_pFilter = (argc > 1) ? argv[1] : NULL;
+
+   static const char* const s_inputs[] = { "text", "binary" };
+   for (uint kind = 0; kind < LZHAM_ARRAY_SIZE(s_inputs); kind++)
+   {
+      std::vector<uint8> buf(make_input(kind, cBufSize));
+
+      bench_checksums(s_inputs[kind], buf);
+      bench_find_all_matches(s_inputs[kind], buf);
+      bench_code_generation(s_inputs[kind], buf);
+      bench_decompress(s_inputs[kind], buf);
+   }
+
+   return 0;
+}
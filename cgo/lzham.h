@@ -41,6 +41,7 @@ extern "C" {
    typedef unsigned char   lzham_uint8;
    typedef signed int      lzham_int32;
    typedef unsigned int    lzham_uint32;
+   typedef unsigned long long lzham_uint64;
    typedef unsigned int    lzham_bool;
 
    // Returns DLL version (LZHAM_DLL_VERSION).
@@ -104,6 +105,11 @@ extern "C" {
 
       LZHAM_TOTAL_COMP_LEVELS,
 
+      // A greedy parse using hash chains, instead of the binary tree match finder and near-optimal parser. Usually faster than
+      // LZHAM_COMP_LEVEL_FASTEST, but not on noisy binary data with many short matches. The ratio is worse, but the stream
+      // format is the same.
+      LZHAM_COMP_LEVEL_GREEDY = LZHAM_TOTAL_COMP_LEVELS,
+
       LZHAM_COMP_LEVEL_FORCE_DWORD = 0xFFFFFFFF
    } lzham_compress_level;
 
@@ -121,6 +127,11 @@ extern "C" {
       LZHAM_COMP_FLAG_TRADEOFF_DECOMPRESSION_RATE_FOR_COMP_RATIO = 16,
       
       LZHAM_COMP_FLAG_WRITE_ZLIB_STREAM = 32,
+
+      // Takes all of the compressor's memory from a bump arena owned by the compressor, which gets large chunks from the allocator and
+      // releases them all at once when the compressor is deinitialized. This avoids contention in the allocator between compressors.
+      // Freed memory is mostly not reused until then, but a reused compressor normally doesn't allocate anything after its first stream.
+      LZHAM_COMP_FLAG_USE_ARENA = 64,
    } lzham_compress_flags;
 
    typedef struct
@@ -134,6 +145,9 @@ extern "C" {
       lzham_uint32 m_compress_flags;         // optional compression flags (see lzham_compress_flags enum)
       lzham_uint32 m_num_seed_bytes;         // for delta compression (optional) - number of seed bytes pointed to by m_pSeed_bytes
       const void *m_pSeed_bytes;             // for delta compression (optional) - pointer to seed bytes buffer, must be at least m_num_seed_bytes long
+      lzham_realloc_func m_pRealloc;         // optional - allocator for this compressor's memory instead of the lzham_set_memory_callbacks() one
+      lzham_msize_func m_pMSize;             // must be set if m_pRealloc is
+      void *m_pAlloc_user_data;              // passed to m_pRealloc and m_pMSize
    } lzham_compress_params;
 
    typedef struct
@@ -182,6 +196,8 @@ extern "C" {
 
    // Single function call compression interface.
    // Same return codes as lzham_compress, except this function can also return LZHAM_COMP_STATUS_OUTPUT_BUF_TOO_SMALL.
+   // Compressed blocks are written directly to pDst_buf, so if it's too small, compression stops as soon as the output
+   // doesn't fit, *pDst_len is set to 0, and the checksums aren't written.
     lzham_compress_status_t LZHAM_CDECL lzham_compress_memory(
       const lzham_compress_params *pParams,
       lzham_uint8* pDst_buf,
@@ -191,6 +207,71 @@ extern "C" {
       lzham_uint32 *pAdler32,
       lzham_uint32 *pCrc32);
 
+   // Single function call compression interface which reuses a compressor created by lzham_compress_init, avoiding the dictionary/match finder allocations.
+   // The compressor is reset before compressing pSrc_buf, so this may be called any number of times with the same state (but not concurrently).
+   // Same return codes as lzham_compress_memory.
+    lzham_compress_status_t LZHAM_CDECL lzham_compress_memory_reinit(
+      lzham_compress_state_ptr pState,
+      lzham_uint8* pDst_buf,
+      size_t *pDst_len,
+      const lzham_uint8* pSrc_buf,
+      size_t src_len,
+      lzham_uint32 *pAdler32,
+      lzham_uint32 *pCrc32);
+
+   typedef enum
+   {
+      LZHAM_COMP_CHUNK_FLAG_FIRST = 1,             // The chunk starts the stream (i.e. it sends the stream configuration).
+      LZHAM_COMP_CHUNK_FLAG_LAST = 2,              // The chunk ends the stream (i.e. it sends the final block with the checksums).
+   } lzham_compress_chunk_flags;
+
+   // Like lzham_compress_memory_reinit, but compresses a single chunk of a stream which is made by concatenating independently compressed
+   // chunks in order, so the chunks can be compressed in parallel. Each chunk after the first can't reference any earlier data, and resets
+   // the decompressor's models in its first compressed block (the same as LZHAM_FULL_FLUSH, but without a sync block, which the unbuffered
+   // decompressor doesn't support), so the ratio is worse than compressing the whole stream at once.
+   // adler32 is the Adler-32 of all the data in the earlier chunks (ignored for the first chunk), and *pAdler32 is set to the Adler-32 of
+   // the stream so far, including this chunk.
+    lzham_compress_status_t LZHAM_CDECL lzham_compress_memory_chunk(
+      lzham_compress_state_ptr pState,
+      lzham_uint8* pDst_buf,
+      size_t *pDst_len,
+      const lzham_uint8* pSrc_buf,
+      size_t src_len,
+      lzham_uint32 chunk_flags,
+      lzham_uint32 adler32,
+      lzham_uint32 *pAdler32,
+      lzham_uint32 *pCrc32);
+
+   // Compression statistics, for finding out where the time goes. Times are in nanoseconds. With helper threads, the match finder runs
+   // concurrently with the parser, so m_match_finder_ns only counts the time spent adding the block and waiting for the helpers to finish.
+   // LZHAM_COMP_LEVEL_GREEDY finds matches and codes each decision as it parses, so all of that is counted in m_parse_ns.
+   typedef struct
+   {
+      lzham_uint32 m_struct_size;            // set to sizeof(lzham_compress_stats)
+      lzham_uint64 m_total_ns;               // time spent in the compression functions (the sum of the three stages below)
+      lzham_uint64 m_match_finder_ns;        // finding matches
+      lzham_uint64 m_parse_ns;               // parsing, including evaluating the cost of each decision
+      lzham_uint64 m_coding_ns;              // everything else (mostly coding the decisions, coding raw blocks and computing checksums)
+      lzham_uint64 m_src_bytes;              // bytes compressed
+      lzham_uint64 m_dst_bytes;              // bytes output, including headers and the final block
+      lzham_uint64 m_compressed_blocks;
+      lzham_uint64 m_raw_blocks;             // blocks stored uncompressed since they didn't compress
+      lzham_uint64 m_literals;               // literals in compressed blocks
+      lzham_uint64 m_delta_literals;         // literals coded relative to the byte at the rep0 distance
+      lzham_uint64 m_rep_matches[4];         // matches using the most recent distances (rep0-rep3)
+      lzham_uint64 m_full_matches;           // matches coding their distance, including len2 matches
+      lzham_uint64 m_len2_matches;
+      lzham_uint64 m_table_rebuilds;         // Huffman/polar table updates, including those of blocks which were then stored
+      lzham_uint64 m_bytes_allocated;        // bytes requested from the allocator by the calling thread
+      lzham_uint64 m_allocs;                 // blocks it allocated or resized for the calling thread
+      lzham_uint64 m_underlying_allocs;      // of those, the ones which reached the underlying allocator (with an arena, its new chunks instead)
+   } lzham_compress_stats;
+
+   // Gets the statistics for the data compressed since the compressor was initialized or reset (i.e. by the last call to
+   // lzham_compress_memory_reinit or lzham_compress_memory_chunk). Be sure to initialize pStats->m_struct_size to sizeof(lzham_compress_stats).
+   // Returns false if the parameters are invalid.
+    lzham_bool LZHAM_CDECL lzham_compress_get_stats(lzham_compress_state_ptr pState, lzham_compress_stats *pStats);
+
    // Decompression
    typedef enum
    {
@@ -239,6 +320,8 @@ extern "C" {
       LZHAM_DECOMP_FLAG_COMPUTE_ADLER32   = 1 << 1,
       LZHAM_DECOMP_FLAG_COMPUTE_CRC32     = 1 << 2,
       LZHAM_DECOMP_FLAG_READ_ZLIB_STREAM  = 1 << 3,
+      LZHAM_DECOMP_FLAG_COLLECT_STATS     = 1 << 4,    // count the decoded symbols and table rebuilds (see lzham_decompress_stats), slightly slower
+      LZHAM_DECOMP_FLAG_USE_ARENA         = 1 << 5,    // take all of the decompressor's memory from a bump arena (see LZHAM_COMP_FLAG_USE_ARENA)
    } lzham_decompress_flags;
 
    // Decompression parameters structure.
@@ -253,6 +336,9 @@ extern "C" {
       lzham_uint32 m_decompress_flags;       // optional decompression flags (see lzham_decompress_flags enum)
       lzham_uint32 m_num_seed_bytes;         // for delta compression (optional) - number of seed bytes pointed to by m_pSeed_bytes
       const void *m_pSeed_bytes;             // for delta compression (optional) - pointer to seed bytes buffer, must be at least m_num_seed_bytes long
+      lzham_realloc_func m_pRealloc;         // optional - allocator for this decompressor's memory instead of the lzham_set_memory_callbacks() one
+      lzham_msize_func m_pMSize;             // must be set if m_pRealloc is
+      void *m_pAlloc_user_data;              // passed to m_pRealloc and m_pMSize
    } lzham_decompress_params;
 
    typedef struct
@@ -268,6 +354,7 @@ extern "C" {
     lzham_decompress_state_ptr LZHAM_CDECL lzham_decompress_init(const lzham_decompress_params *pParams);
 
    // Quickly re-initializes the decompressor to its initial state given an already allocated/initialized state (doesn't do any memory alloc unless necessary).
+   // The decompressor keeps the allocator it was initialized with (pParams->m_pRealloc and LZHAM_DECOMP_FLAG_USE_ARENA are ignored).
     lzham_decompress_state_ptr LZHAM_CDECL lzham_decompress_reinit(lzham_decompress_state_ptr pState, const lzham_decompress_params *pParams);
 
    // Deinitializes a decompressor.
@@ -304,6 +391,45 @@ extern "C" {
       lzham_uint32 *pAdler32,
       lzham_uint32 *pCrc32);
 
+   // Single function call interface which reuses a decompressor created by lzham_decompress_init. The decompressor is reinitialized (in unbuffered
+   // mode) before decompressing pSrc_buf, so after the first call this doesn't allocate any memory. Same return codes as lzham_decompress_memory.
+    lzham_decompress_status_t LZHAM_CDECL lzham_decompress_memory_reinit(
+      lzham_decompress_state_ptr pState,
+      lzham_uint8* pDst_buf,
+      size_t *pDst_len,
+      const lzham_uint8* pSrc_buf,
+      size_t src_len,
+      lzham_uint32 *pAdler32,
+      lzham_uint32 *pCrc32);
+
+   // Decompression statistics. Times are in nanoseconds.
+   typedef struct
+   {
+      lzham_uint32 m_struct_size;            // set to sizeof(lzham_decompress_stats)
+      lzham_uint64 m_total_ns;               // time spent in the decompression functions
+      lzham_uint64 m_src_bytes;              // bytes consumed
+      lzham_uint64 m_dst_bytes;              // bytes output
+      lzham_uint64 m_compressed_blocks;
+      lzham_uint64 m_raw_blocks;
+      lzham_uint64 m_bytes_allocated;        // bytes requested from the allocator by the calling thread
+      lzham_uint64 m_allocs;                 // blocks it allocated or resized for the calling thread
+      lzham_uint64 m_underlying_allocs;      // of those, the ones which reached the underlying allocator (with an arena, its new chunks instead)
+
+      // The rest are only counted with LZHAM_DECOMP_FLAG_COLLECT_STATS.
+      lzham_uint64 m_literals;
+      lzham_uint64 m_delta_literals;         // literals coded relative to the byte at the rep0 distance
+      lzham_uint64 m_rep_matches[4];         // matches using the most recent distances (rep0-rep3)
+      lzham_uint64 m_full_matches;           // matches coding their distance, including len2 matches
+      lzham_uint64 m_len2_matches;
+      lzham_uint64 m_table_rebuilds;         // Huffman/polar table updates
+      lzham_uint64 m_table_rebuild_ns;       // time spent rebuilding the tables (included in m_total_ns)
+   } lzham_decompress_stats;
+
+   // Gets the statistics for the data decompressed since the decompressor was initialized or reinitialized (i.e. by the last call to
+   // lzham_decompress_memory_reinit). Be sure to initialize pStats->m_struct_size to sizeof(lzham_decompress_stats).
+   // Returns false if the parameters are invalid.
+    lzham_bool LZHAM_CDECL lzham_decompress_get_stats(lzham_decompress_state_ptr pState, lzham_decompress_stats *pStats);
+
    // ------------------- zlib-style API Definitions.
    
    // Important note: LZHAM doesn't internally support the Deflate algorithm, but for API compatibility the "Deflate" and "Inflate" names are retained here.
@@ -532,12 +658,17 @@ extern "C" {
    typedef lzham_compress_status_t (LZHAM_CDECL *lzham_compress_func)(lzham_compress_state_ptr pState, const lzham_uint8 *pIn_buf, size_t *pIn_buf_size, lzham_uint8 *pOut_buf, size_t *pOut_buf_size, lzham_bool no_more_input_bytes_flag);
    typedef lzham_compress_status_t (LZHAM_CDECL *lzham_compress2_func)(lzham_compress_state_ptr pState, const lzham_uint8 *pIn_buf, size_t *pIn_buf_size, lzham_uint8 *pOut_buf, size_t *pOut_buf_size, lzham_flush_t flush_type);
    typedef lzham_compress_status_t (LZHAM_CDECL *lzham_compress_memory_func)(const lzham_compress_params *pParams, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32* pCrc32);
+   typedef lzham_compress_status_t (LZHAM_CDECL *lzham_compress_memory_reinit_func)(lzham_compress_state_ptr pState, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32* pCrc32);
+   typedef lzham_compress_status_t (LZHAM_CDECL *lzham_compress_memory_chunk_func)(lzham_compress_state_ptr pState, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 chunk_flags, lzham_uint32 adler32, lzham_uint32 *pAdler32, lzham_uint32* pCrc32);
+   typedef lzham_bool (LZHAM_CDECL *lzham_compress_get_stats_func)(lzham_compress_state_ptr pState, lzham_compress_stats *pStats);
 
    typedef lzham_decompress_state_ptr (LZHAM_CDECL *lzham_decompress_init_func)(const lzham_decompress_params *pParams);
    typedef lzham_decompress_state_ptr (LZHAM_CDECL *lzham_decompress_reinit_func)(lzham_compress_state_ptr pState, const lzham_decompress_params *pParams);
    typedef lzham_decompress_checksums* (LZHAM_CDECL *lzham_decompress_deinit_func)(lzham_decompress_state_ptr pState);
    typedef lzham_decompress_status_t (LZHAM_CDECL *lzham_decompress_func)(lzham_decompress_state_ptr pState, const lzham_uint8 *pIn_buf, size_t *pIn_buf_size, lzham_uint8 *pOut_buf, size_t *pOut_buf_size, lzham_bool no_more_input_bytes_flag);
    typedef lzham_decompress_status_t (LZHAM_CDECL *lzham_decompress_memory_func)(const lzham_decompress_params *pParams, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32);
+   typedef lzham_decompress_status_t (LZHAM_CDECL *lzham_decompress_memory_reinit_func)(lzham_decompress_state_ptr pState, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32);
+   typedef lzham_bool (LZHAM_CDECL *lzham_decompress_get_stats_func)(lzham_decompress_state_ptr pState, lzham_decompress_stats *pStats);
 
    typedef const char *(LZHAM_CDECL *lzham_z_version_func)(void);
    typedef int (LZHAM_CDECL *lzham_z_deflateInit_func)(lzham_z_streamp pStream, int level);
@@ -43,6 +43,16 @@ extern "C" lzham_decompress_status_t lzham_decompress_memory(const lzham_decompr
    return lzham::lzham_lib_decompress_memory(pParams, pDst_buf, pDst_len, pSrc_buf, src_len, pAdler32, pCrc32);
 }
 
+extern "C" lzham_decompress_status_t lzham_decompress_memory_reinit(lzham_decompress_state_ptr p, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32)
+{
+   return lzham::lzham_lib_decompress_memory_reinit(p, pDst_buf, pDst_len, pSrc_buf, src_len, pAdler32, pCrc32);
+}
+
+extern "C" lzham_bool lzham_decompress_get_stats(lzham_decompress_state_ptr p, lzham_decompress_stats *pStats)
+{
+   return lzham::lzham_lib_decompress_get_stats(p, pStats);
+}
+
 extern "C" lzham_compress_state_ptr lzham_compress_init(const lzham_compress_params *pParams)
 {
    return lzham::lzham_lib_compress_init(pParams);
@@ -81,6 +91,21 @@ extern "C" lzham_compress_status_t lzham_compress_memory(const lzham_compress_pa
    return lzham::lzham_lib_compress_memory(pParams, pDst_buf, pDst_len, pSrc_buf, src_len, pAdler32, pCrc32);
 }
 
+extern "C" lzham_compress_status_t lzham_compress_memory_reinit(lzham_compress_state_ptr p, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 * pCrc32)
+{
+   return lzham::lzham_lib_compress_memory_reinit(p, pDst_buf, pDst_len, pSrc_buf, src_len, pAdler32, pCrc32);
+}
+
+extern "C" lzham_compress_status_t lzham_compress_memory_chunk(lzham_compress_state_ptr p, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 chunk_flags, lzham_uint32 adler32, lzham_uint32 *pAdler32, lzham_uint32 * pCrc32)
+{
+   return lzham::lzham_lib_compress_memory_chunk(p, pDst_buf, pDst_len, pSrc_buf, src_len, chunk_flags, adler32, pAdler32, pCrc32);
+}
+
+extern "C" lzham_bool lzham_compress_get_stats(lzham_compress_state_ptr p, lzham_compress_stats *pStats)
+{
+   return lzham::lzham_lib_compress_get_stats(p, pStats);
+}
+
 // ----------------- zlib-style API's
 
 extern "C" const char *lzham_z_version(void)
@@ -9,5 +9,10 @@ namespace lzham
    
    const uint cInitCRC32 = 0U;
    uint crc32(uint crc, const lzham_uint8 *ptr, size_t buf_len);
+   uint crc32_combine(uint crc1, uint crc2, uint64 len2);
+
+   // Updates *pAdler32 and *pCRC32 with the buffer. Both are computed over each 8 KiB chunk in turn, so the second pass
+   // reads it from L1 instead of memory.
+   void adler32_crc32(const void* pBuf, size_t buflen, uint* pAdler32, uint* pCRC32);
    
 }  // namespace lzham
@@ -25,6 +25,12 @@ namespace lzham
    
    lzham_compress_status_t LZHAM_CDECL lzham_lib_compress_memory(const lzham_compress_params *pParams, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32* pCrc32);
 
+   lzham_compress_status_t LZHAM_CDECL lzham_lib_compress_memory_reinit(lzham_compress_state_ptr p, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32* pCrc32);
+
+   lzham_compress_status_t LZHAM_CDECL lzham_lib_compress_memory_chunk(lzham_compress_state_ptr p, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 chunk_flags, lzham_uint32 adler32, lzham_uint32 *pAdler32, lzham_uint32* pCrc32);
+
+   lzham_bool LZHAM_CDECL lzham_lib_compress_get_stats(lzham_compress_state_ptr p, lzham_compress_stats *pStats);
+
    int lzham_lib_z_deflateInit(lzham_z_streamp pStream, int level);
    int lzham_lib_z_deflateInit2(lzham_z_streamp pStream, int level, int method, int window_bits, int mem_level, int strategy);
    int lzham_lib_z_deflateReset(lzham_z_streamp pStream);
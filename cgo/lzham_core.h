@@ -14,14 +14,19 @@
   #define LZHAM_CPU_HAS_64BIT_REGISTERS 0
 #endif
 
-#define LZHAM_USE_UNALIGNED_INT_LOADS 0
-
 #if __BIG_ENDIAN__
   #define LZHAM_BIG_ENDIAN_CPU 1
 #else
   #define LZHAM_LITTLE_ENDIAN_CPU 1
 #endif
 
+// Unaligned loads are cheap on the little-endian targets we build for.
+#if LZHAM_LITTLE_ENDIAN_CPU && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86) || defined(__aarch64__) || defined(__wasm__))
+  #define LZHAM_USE_UNALIGNED_INT_LOADS 1
+#else
+  #define LZHAM_USE_UNALIGNED_INT_LOADS 0
+#endif
+
 #define LZHAM_RESTRICT
 #define LZHAM_FORCE_INLINE inline
 
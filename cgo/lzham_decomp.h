@@ -23,6 +23,12 @@ namespace lzham
       lzham_uint8* pDst_buf, size_t *pDst_len, 
       const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32* pCrc32);
 
+   lzham_decompress_status_t LZHAM_CDECL lzham_lib_decompress_memory_reinit(lzham_decompress_state_ptr pState,
+      lzham_uint8* pDst_buf, size_t *pDst_len,
+      const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32* pCrc32);
+
+   lzham_bool LZHAM_CDECL lzham_lib_decompress_get_stats(lzham_decompress_state_ptr pState, lzham_decompress_stats *pStats);
+
    int LZHAM_CDECL lzham_lib_z_inflateInit2(lzham_z_streamp pStream, int window_bits);
    int LZHAM_CDECL lzham_lib_z_inflateInit(lzham_z_streamp pStream);
    int LZHAM_CDECL lzham_lib_z_inflateReset(lzham_z_streamp pStream);
@@ -29,8 +29,16 @@ namespace lzham
       lzham_compress_params m_params;
 
       lzham_compress_status_t m_status;
+
+      // Everything above is allocated with this, including the state itself.
+      context_allocator m_allocator;
    };
 
+   static bool init_context_allocator(context_allocator &allocator, const lzham_compress_params *pParams)
+   {
+      return allocator.init(pParams->m_pRealloc, pParams->m_pMSize, pParams->m_pAlloc_user_data, (pParams->m_compress_flags & LZHAM_COMP_FLAG_USE_ARENA) != 0);
+   }
+
    static lzham_compress_status_t create_internal_init_params(lzcompressor::init_params &internal_params, const lzham_compress_params *pParams)
    {
       if ((pParams->m_dict_size_log2 < CLZBase::cMinDictSizeLog2) || (pParams->m_dict_size_log2 > CLZBase::cMaxDictSizeLog2))
@@ -70,6 +78,7 @@ namespace lzham
          case LZHAM_COMP_LEVEL_DEFAULT:   internal_params.m_compression_level = cCompressionLevelDefault; break;
          case LZHAM_COMP_LEVEL_BETTER:    internal_params.m_compression_level = cCompressionLevelBetter; break;
          case LZHAM_COMP_LEVEL_UBER:      internal_params.m_compression_level = cCompressionLevelUber; break;
+         case LZHAM_COMP_LEVEL_GREEDY:    internal_params.m_compression_level = cCompressionLevelGreedy; break;
          default:
             return LZHAM_COMP_STATUS_INVALID_PARAMETER;
       };
@@ -90,11 +99,21 @@ namespace lzham
       if (status != LZHAM_COMP_STATUS_SUCCESS)
          return NULL;
 
+      context_allocator allocator;
+      if (!init_context_allocator(allocator, pParams))
+         return NULL;
+
+      memory_scope scope(&allocator.m_allocator);
+
       lzham_compress_state *pState = lzham_new<lzham_compress_state>();
       if (!pState)
+      {
+         allocator.deinit();
          return NULL;
+      }
 
       pState->m_params = *pParams;
+      pState->m_allocator = allocator;
 
       pState->m_pIn_buf = NULL;
       pState->m_pIn_buf_size = NULL;
@@ -109,6 +128,7 @@ namespace lzham
          if (!pState->m_tp.init(internal_params.m_max_helper_threads))
          {
             lzham_delete(pState);
+            allocator.deinit();
             return NULL;
          }
          if (pState->m_tp.get_num_threads() >= internal_params.m_max_helper_threads)
@@ -124,6 +144,7 @@ namespace lzham
       if (!pState->m_compressor.init(internal_params))
       {
          lzham_delete(pState);
+         allocator.deinit();
          return NULL;
       }
 
@@ -135,6 +156,8 @@ namespace lzham
       lzham_compress_state *pState = static_cast<lzham_compress_state*>(p);
       if (pState)
       {
+         memory_scope scope(&pState->m_allocator.m_allocator);
+
          if (!pState->m_compressor.reset())
             return NULL;
 
@@ -160,7 +183,13 @@ namespace lzham
       checksums->adler32 = pState->m_compressor.get_src_adler32();
       checksums->crc32 = pState->m_compressor.get_src_crc32();
 
-      lzham_delete(pState);
+      context_allocator allocator(pState->m_allocator);
+      {
+         memory_scope scope(&allocator.m_allocator);
+         lzham_delete(pState);
+      }
+      allocator.deinit();
+
       return checksums;
    }
 
@@ -173,14 +202,21 @@ namespace lzham
       return lzham_lib_compress2(p, pIn_buf, pIn_buf_size, pOut_buf, pOut_buf_size, no_more_input_bytes_flag ? LZHAM_FINISH : LZHAM_NO_FLUSH);
    }
 
-   lzham_compress_status_t LZHAM_CDECL lzham_lib_compress2(
-      lzham_compress_state_ptr p,
-      const lzham_uint8 *pIn_buf, size_t *pIn_buf_size,
-      lzham_uint8 *pOut_buf, size_t *pOut_buf_size,
-      lzham_flush_t flush_type)
+   // Adds the time and allocations since a compression function was called to the compressor's statistics. The rest of the time not
+   // spent in the match finder or parser is counted as coding.
+   static void update_perf_stats(lzcompressor &compressor, uint64 start_time, const lzham_alloc_stats &start_allocs)
    {
-      lzham_compress_state *pState = static_cast<lzham_compress_state*>(p);
+      const lzham_alloc_stats &allocs = lzham_get_alloc_stats();
+      lzham_compress_stats &stats = compressor.get_perf_stats();
+      stats.m_total_ns += get_time_ns() - start_time;
+      stats.m_coding_ns = stats.m_total_ns - stats.m_match_finder_ns - stats.m_parse_ns;
+      stats.m_bytes_allocated += allocs.m_bytes - start_allocs.m_bytes;
+      stats.m_allocs += allocs.m_allocs - start_allocs.m_allocs;
+      stats.m_underlying_allocs += allocs.m_underlying_allocs - start_allocs.m_underlying_allocs;
+   }
 
+   static lzham_compress_status_t compress2_internal(lzham_compress_state *pState, const lzham_uint8 *pIn_buf, size_t *pIn_buf_size, lzham_uint8 *pOut_buf, size_t *pOut_buf_size, lzham_flush_t flush_type)
+   {
       if ((!pState) || (!pState->m_params.m_dict_size_log2) || (pState->m_status >= LZHAM_COMP_STATUS_FIRST_SUCCESS_OR_FAILURE_CODE) || (!pIn_buf_size) || (!pOut_buf_size))
          return LZHAM_COMP_STATUS_INVALID_PARAMETER;
 
@@ -296,9 +332,31 @@ namespace lzham
       return pState->m_status;
    }
 
-   lzham_compress_status_t LZHAM_CDECL lzham_lib_compress_memory(const lzham_compress_params *pParams, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32)
+   lzham_compress_status_t LZHAM_CDECL lzham_lib_compress2(
+      lzham_compress_state_ptr p,
+      const lzham_uint8 *pIn_buf, size_t *pIn_buf_size,
+      lzham_uint8 *pOut_buf, size_t *pOut_buf_size,
+      lzham_flush_t flush_type)
+   {
+      lzham_compress_state *pState = static_cast<lzham_compress_state*>(p);
+
+      if ((!pState) || (!pState->m_params.m_dict_size_log2))
+         return LZHAM_COMP_STATUS_INVALID_PARAMETER;
+
+      memory_scope scope(&pState->m_allocator.m_allocator);
+
+      const uint64 start_time = get_time_ns();
+      const lzham_alloc_stats start_allocs = lzham_get_alloc_stats();
+
+      lzham_compress_status_t status = compress2_internal(pState, pIn_buf, pIn_buf_size, pOut_buf, pOut_buf_size, flush_type);
+
+      update_perf_stats(pState->m_compressor, start_time, start_allocs);
+      return status;
+   }
+
+   static lzham_compress_status_t check_memory_params(size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len)
    {
-      if ((!pParams) || (!pDst_len))
+      if (!pDst_len)
          return LZHAM_COMP_STATUS_INVALID_PARAMETER;
 
       if (src_len)
@@ -313,11 +371,53 @@ namespace lzham
             return LZHAM_COMP_STATUS_INVALID_PARAMETER;
       }
 
-      lzcompressor::init_params internal_params;
-      lzham_compress_status_t status = create_internal_init_params(internal_params, pParams);
-      if (status != LZHAM_COMP_STATUS_SUCCESS)
-         return status;
+      return LZHAM_COMP_STATUS_SUCCESS;
+   }
+
+   // Compresses the entire source buffer using an initialized (or freshly reset) compressor, writing each block straight to the
+   // caller's buffer. Stops as soon as the compressed data doesn't fit. If finish is false, the final block isn't sent (see
+   // lzham_lib_compress_memory_chunk).
+   static lzham_compress_status_t compress_memory_internal(lzcompressor &compressor, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32, bool finish = true)
+   {
+      // Even an empty stream has a final block.
+      if (!pDst_buf)
+      {
+         *pDst_len = 0;
+         return LZHAM_COMP_STATUS_OUTPUT_BUF_TOO_SMALL;
+      }
+
+      const uint64 start_time = get_time_ns();
+      const lzham_alloc_stats start_allocs = lzham_get_alloc_stats();
+
+      bool status = compressor.set_output_buf(pDst_buf, *pDst_len);
+
+      if ((status) && (src_len))
+         status = compressor.put_bytes(pSrc_buf, static_cast<uint32>(src_len));
+
+      if (status)
+         status = finish ? compressor.put_bytes(NULL, 0) : compressor.end_chunk();
+
+      update_perf_stats(compressor, start_time, start_allocs);
+
+      if (!status)
+      {
+         *pDst_len = 0;
+         return compressor.get_output_buf_overflow() ? LZHAM_COMP_STATUS_OUTPUT_BUF_TOO_SMALL : LZHAM_COMP_STATUS_FAILED;
+      }
+
+      *pDst_len = compressor.get_output_buf_ofs();
+
+      if (pAdler32)
+         *pAdler32 = compressor.get_src_adler32();
+      if (pCrc32)
+          *pCrc32 = compressor.get_src_crc32();
+
+      return LZHAM_COMP_STATUS_SUCCESS;
+   }
 
+   // Compresses with a new compressor, for lzham_lib_compress_memory.
+   static lzham_compress_status_t compress_memory_new_compressor(lzcompressor::init_params &internal_params, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32)
+   {
       task_pool *pTP = NULL;
       if (internal_params.m_max_helper_threads)
       {
@@ -342,47 +442,102 @@ namespace lzham
          return LZHAM_COMP_STATUS_INVALID_PARAMETER;
       }
 
-      if (src_len)
-      {
-         if (!pCompressor->put_bytes(pSrc_buf, static_cast<uint32>(src_len)))
-         {
-            *pDst_len = 0;
-            lzham_delete(pTP);
-            lzham_delete(pCompressor);
-            return LZHAM_COMP_STATUS_FAILED;
-         }
-      }
+      lzham_compress_status_t status = compress_memory_internal(*pCompressor, pDst_buf, pDst_len, pSrc_buf, src_len, pAdler32, pCrc32);
 
-      if (!pCompressor->put_bytes(NULL, 0))
-      {
-         *pDst_len = 0;
-         lzham_delete(pTP);
-         lzham_delete(pCompressor);
+      lzham_delete(pTP);
+      lzham_delete(pCompressor);
+      return status;
+   }
+
+   lzham_compress_status_t LZHAM_CDECL lzham_lib_compress_memory(const lzham_compress_params *pParams, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32)
+   {
+      if (!pParams)
+         return LZHAM_COMP_STATUS_INVALID_PARAMETER;
+
+      lzham_compress_status_t status = check_memory_params(pDst_len, pSrc_buf, src_len);
+      if (status != LZHAM_COMP_STATUS_SUCCESS)
+         return status;
+
+      lzcompressor::init_params internal_params;
+      status = create_internal_init_params(internal_params, pParams);
+      if (status != LZHAM_COMP_STATUS_SUCCESS)
+         return status;
+
+      context_allocator allocator;
+      if (!init_context_allocator(allocator, pParams))
          return LZHAM_COMP_STATUS_FAILED;
+
+      {
+         memory_scope scope(&allocator.m_allocator);
+         status = compress_memory_new_compressor(internal_params, pDst_buf, pDst_len, pSrc_buf, src_len, pAdler32, pCrc32);
       }
 
-      const byte_vec &comp_data = pCompressor->get_compressed_data();
+      allocator.deinit();
+      return status;
+   }
 
-      size_t dst_buf_size = *pDst_len;
-      *pDst_len = comp_data.size();
+   lzham_compress_status_t LZHAM_CDECL lzham_lib_compress_memory_reinit(lzham_compress_state_ptr p, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32)
+   {
+      lzham_compress_state *pState = static_cast<lzham_compress_state*>(p);
+      if (!pState)
+         return LZHAM_COMP_STATUS_INVALID_PARAMETER;
 
-      if (pAdler32)
-         *pAdler32 = pCompressor->get_src_adler32();
-      if (pCrc32)
-          *pCrc32 = pCompressor->get_src_crc32();
+      memory_scope scope(&pState->m_allocator.m_allocator);
+
+      lzham_compress_status_t status = check_memory_params(pDst_len, pSrc_buf, src_len);
+      if (status != LZHAM_COMP_STATUS_SUCCESS)
+         return status;
+
+      if (!lzham_lib_compress_reinit(pState))
+         return LZHAM_COMP_STATUS_FAILED_INITIALIZING;
+
+      status = compress_memory_internal(pState->m_compressor, pDst_buf, pDst_len, pSrc_buf, src_len, pAdler32, pCrc32);
+
+      pState->m_finished_compression = true;
+      pState->m_status = status;
+      return status;
+   }
+
+   lzham_compress_status_t LZHAM_CDECL lzham_lib_compress_memory_chunk(lzham_compress_state_ptr p, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 chunk_flags, lzham_uint32 adler32, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32)
+   {
+      lzham_compress_state *pState = static_cast<lzham_compress_state*>(p);
+      if (!pState)
+         return LZHAM_COMP_STATUS_INVALID_PARAMETER;
+
+      memory_scope scope(&pState->m_allocator.m_allocator);
+
+      lzham_compress_status_t status = check_memory_params(pDst_len, pSrc_buf, src_len);
+      if (status != LZHAM_COMP_STATUS_SUCCESS)
+         return status;
 
-      if (comp_data.size() > dst_buf_size)
+      if (!lzham_lib_compress_reinit(pState))
+         return LZHAM_COMP_STATUS_FAILED_INITIALIZING;
+
+      if ((chunk_flags & LZHAM_COMP_CHUNK_FLAG_FIRST) == 0)
       {
-         lzham_delete(pTP);
-         lzham_delete(pCompressor);
-         return LZHAM_COMP_STATUS_OUTPUT_BUF_TOO_SMALL;
+         // Seed bytes (or a zlib header) can only be at the start of the stream.
+         if ((pState->m_params.m_num_seed_bytes) || (pState->m_params.m_compress_flags & LZHAM_COMP_FLAG_WRITE_ZLIB_STREAM))
+            return LZHAM_COMP_STATUS_INVALID_PARAMETER;
+
+         pState->m_compressor.begin_chunk(adler32);
       }
 
-      memcpy(pDst_buf, comp_data.get_ptr(), comp_data.size());
+      status = compress_memory_internal(pState->m_compressor, pDst_buf, pDst_len, pSrc_buf, src_len, pAdler32, pCrc32, (chunk_flags & LZHAM_COMP_CHUNK_FLAG_LAST) != 0);
 
-      lzham_delete(pTP);
-      lzham_delete(pCompressor);
-      return LZHAM_COMP_STATUS_SUCCESS;
+      pState->m_finished_compression = true;
+      pState->m_status = status;
+      return status;
+   }
+
+   lzham_bool LZHAM_CDECL lzham_lib_compress_get_stats(lzham_compress_state_ptr p, lzham_compress_stats *pStats)
+   {
+      lzham_compress_state *pState = static_cast<lzham_compress_state*>(p);
+      if ((!pState) || (!pStats) || (pStats->m_struct_size != sizeof(lzham_compress_stats)))
+         return false;
+
+      *pStats = pState->m_compressor.get_perf_stats();
+      pStats->m_struct_size = sizeof(lzham_compress_stats);
+      return true;
    }
 
    // ----------------- zlib-style API's
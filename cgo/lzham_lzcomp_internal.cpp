@@ -59,6 +59,14 @@ namespace lzham
          false,                           // m_use_polar_codes
          UINT_MAX,                        // m_match_accel_max_matches_per_probe
          cMatchAccelMaxSupportedProbes,   // m_match_accel_max_probes
+      },
+      // cCompressionLevelGreedy
+      {
+         32,                              // m_fast_bytes (hash chain searches stop at a match this long)
+         true,                            // m_fast_adaptive_huffman_updating
+         true,                            // m_use_polar_codes
+         1,                               // m_match_accel_max_matches_per_probe
+         8,                               // m_match_accel_max_probes (hash chain depth)
       }
    };
 
@@ -66,9 +74,16 @@ namespace lzham
       m_src_size(-1),
       m_src_adler32(0),
       m_src_crc32(0),
+      m_pOut_buf(NULL),
+      m_out_buf_size(0),
+      m_out_buf_ofs(0),
+      m_out_buf_overflow(false),
       m_step(0),
       m_block_start_dict_ofs(0),
       m_block_index(0),
+      m_continue_stream(false),
+      m_reset_tables_pending(false),
+      m_reset_state_pending(false),
       m_finished(false),
       m_num_parse_threads(0),
       m_parse_jobs_remaining(0),
@@ -91,6 +106,12 @@ namespace lzham
             return false;
          m_accel.add_bytes_end();
 
+         if (m_params.m_compression_level == cCompressionLevelGreedy)
+         {
+            for (uint i = 0; i < num_bytes_to_add; i++)
+               m_accel.insert_hash_chain(m_accel.get_lookahead_pos() + i);
+         }
+
          m_accel.advance_bytes(num_bytes_to_add);
 
          cur_seed_ofs += num_bytes_to_add;
@@ -105,7 +126,7 @@ namespace lzham
 
       if ((params.m_dict_size_log2 < CLZBase::cMinDictSizeLog2) || (params.m_dict_size_log2 > CLZBase::cMaxDictSizeLog2))
          return false;
-      if ((params.m_compression_level < 0) || (params.m_compression_level > cCompressionLevelCount))
+      if ((params.m_compression_level < 0) || (params.m_compression_level >= cCompressionLevelCount))
          return false;
 
       m_params = params;
@@ -150,7 +171,12 @@ namespace lzham
          LZHAM_ASSERT((match_accel_helper_threads + (m_num_parse_threads - 1)) <= params.m_max_helper_threads);
       }
 
-      if (!m_accel.init(this, params.m_pTask_pool, match_accel_helper_threads, dict_size, m_settings.m_match_accel_max_matches_per_probe, false, m_settings.m_match_accel_max_probes))
+      // The greedy level finds matches as it parses, so it doesn't use any helper threads.
+      const bool hash_chains = (m_params.m_compression_level == cCompressionLevelGreedy);
+      if (hash_chains)
+         match_accel_helper_threads = 0;
+
+      if (!m_accel.init(this, params.m_pTask_pool, match_accel_helper_threads, dict_size, m_settings.m_match_accel_max_matches_per_probe, false, m_settings.m_match_accel_max_probes, hash_chains))
          return false;
 
       init_position_slots(params.m_dict_size_log2);
@@ -158,12 +184,9 @@ namespace lzham
 
       if (!m_state.init(*this, m_settings.m_fast_adaptive_huffman_updating, m_settings.m_use_polar_codes))
          return false;
+      m_initial_state = m_state;
 
-      if (!m_block_buf.try_reserve(m_params.m_block_size))
-         return false;
-
-      if (!m_comp_buf.try_reserve(m_params.m_block_size*2))
-         return false;
+      // m_block_buf and m_comp_buf grow as needed, so small inputs don't allocate a whole block's worth of buffers up front.
 
       for (uint i = 0; i < m_num_parse_threads; i++)
       {
@@ -203,6 +226,7 @@ namespace lzham
       switch (m_params.m_compression_level)
       {
          case LZHAM_COMP_LEVEL_FASTEST:
+         case LZHAM_COMP_LEVEL_GREEDY:
          {
             flg = 0 << 6;
             break;
@@ -262,13 +286,21 @@ namespace lzham
       m_src_crc32 = cInitCRC32;
       m_block_buf.clear();
       m_comp_buf.clear();
+      m_pOut_buf = NULL;
+      m_out_buf_size = 0;
+      m_out_buf_ofs = 0;
+      m_out_buf_overflow = false;
 
       m_step = 0;
       m_finished = false;
       m_use_task_pool = false;
       m_block_start_dict_ofs = 0;
       m_block_index = 0;
+      m_continue_stream = false;
+      m_reset_tables_pending = false;
+      m_reset_state_pending = false;
       m_state.clear();
+      utils::zero_object(m_perf_stats);
       m_num_parse_threads = 0;
       m_parse_jobs_remaining = 0;
 
@@ -300,17 +332,24 @@ namespace lzham
       m_accel.reset();
       m_codec.reset();
       m_stats.clear();
+      utils::zero_object(m_perf_stats);
       m_src_size = 0;
       m_src_adler32 = cInitAdler32;
       m_src_crc32 = cInitCRC32;
       m_block_buf.try_resize(0);
       m_comp_buf.try_resize(0);
+      m_pOut_buf = NULL;
+      m_out_buf_size = 0;
+      m_out_buf_ofs = 0;
+      m_out_buf_overflow = false;
 
       m_step = 0;
       m_finished = false;
       m_block_start_dict_ofs = 0;
       m_block_index = 0;
-      m_state.reset();
+      m_continue_stream = false;
+      m_reset_tables_pending = false;
+      m_reset_state_pending = true;
 
       m_block_history_size = 0;
       m_block_history_next = 0;
@@ -324,6 +363,49 @@ namespace lzham
       return send_zlib_header();
    }
 
+   bool lzcompressor::set_output_buf(uint8* pBuf, size_t buf_size)
+   {
+      m_pOut_buf = pBuf;
+      m_out_buf_size = buf_size;
+      m_out_buf_ofs = 0;
+      m_out_buf_overflow = false;
+
+      if ((pBuf) && (m_comp_buf.size()))
+      {
+         bool status = output_compressed_data(m_comp_buf);
+         m_comp_buf.try_resize(0);
+         return status;
+      }
+
+      return true;
+   }
+
+   bool lzcompressor::output_compressed_data(byte_vec& buf)
+   {
+      m_perf_stats.m_dst_bytes += buf.size();
+
+      if (m_pOut_buf)
+      {
+         if (buf.size() > (m_out_buf_size - m_out_buf_ofs))
+         {
+            m_out_buf_overflow = true;
+            return false;
+         }
+
+         memcpy(m_pOut_buf + m_out_buf_ofs, buf.get_ptr(), buf.size());
+         m_out_buf_ofs += buf.size();
+         return true;
+      }
+
+      if (m_comp_buf.empty())
+      {
+         m_comp_buf.swap(buf);
+         return true;
+      }
+
+      return m_comp_buf.append(buf);
+   }
+
    bool lzcompressor::code_decision(lzdecision lzdec, uint& cur_ofs, uint& bytes_to_match)
    {
 #ifdef LZHAM_LZVERIFY
@@ -337,6 +419,23 @@ namespace lzham
 
       const uint len = lzdec.get_len();
 
+      decision_counts &counts = m_block_decision_counts;
+      if (lzdec.is_lit())
+      {
+         if (m_state.will_reference_last_match(lzdec))
+            counts.m_delta_literals++;
+         else
+            counts.m_literals++;
+      }
+      else if (lzdec.is_rep())
+         counts.m_rep_matches[-lzdec.m_dist - 1]++;
+      else
+      {
+         counts.m_full_matches++;
+         if (len == CLZBase::cMinMatchLen)
+            counts.m_len2_matches++;
+      }
+
       if (!m_state.encode(m_codec, *this, m_accel, lzdec))
          return false;
 
@@ -386,7 +485,7 @@ namespace lzham
          return false;
       if (!m_codec.stop_encoding(true))
          return false;
-      if (!m_comp_buf.append(m_codec.get_encoding_buf()))
+      if (!output_compressed_data(m_codec.get_encoding_buf()))
          return false;
 
       m_block_index++;
@@ -414,7 +513,7 @@ namespace lzham
          if (LZHAM_FULL_FLUSH == flush_type)
          {
             m_accel.flush();
-            m_state.reset();
+            m_reset_state_pending = true;
          }
       }
 
@@ -493,6 +592,36 @@ namespace lzham
       return status;
    }
 
+   void lzcompressor::begin_chunk(uint adler32)
+   {
+      LZHAM_ASSERT((!m_block_index) && (!m_src_size));
+
+      // The decompressor's tables have been updated by the earlier chunks, but this compressor's are fresh, so the first compressed
+      // block resets them. A full flush would do the same, but the unbuffered decompressor can't continue after a full flush sync block.
+      m_continue_stream = true;
+      m_reset_tables_pending = true;
+      m_src_adler32 = adler32;
+   }
+
+   bool lzcompressor::end_chunk()
+   {
+      LZHAM_ASSERT(!m_finished);
+      if (m_finished)
+         return false;
+
+      bool status = true;
+      if (m_block_buf.size())
+      {
+         status = compress_block(m_block_buf.get_ptr(), m_block_buf.size());
+
+         m_block_buf.try_resize(0);
+      }
+
+      m_finished = true;
+
+      return status;
+   }
+
    bool lzcompressor::send_final_block()
    {
       if (!m_codec.start_encoding(16))
@@ -519,15 +648,8 @@ namespace lzham
       if (!m_codec.stop_encoding(true))
          return false;
 
-      if (m_comp_buf.empty())
-      {
-         m_comp_buf.swap(m_codec.get_encoding_buf());
-      }
-      else
-      {
-         if (!m_comp_buf.append(m_codec.get_encoding_buf()))
-            return false;
-      }
+      if (!output_compressed_data(m_codec.get_encoding_buf()))
+         return false;
 
       m_block_index++;
 
@@ -540,6 +662,10 @@ namespace lzham
 
    bool lzcompressor::send_configuration()
    {
+      // The configuration was sent at the start of the stream, by the first chunk.
+      if (m_continue_stream)
+         return true;
+
       if (!m_codec.encode_bits(m_settings.m_fast_adaptive_huffman_updating, 1))
          return false;
       if (!m_codec.encode_bits(m_settings.m_use_polar_codes, 1))
@@ -751,9 +877,7 @@ namespace lzham
                   const uint comp_pos = static_cast<uint>((m_accel.m_lookahead_pos + cur_lookahead_ofs - dist) & m_accel.m_max_dict_size_mask);
                   const uint8* pComp = &m_accel.m_dict[comp_pos];
 
-                  for (hist_match_len = 0; hist_match_len < max_admissable_match_len; hist_match_len++)
-                     if (pComp[hist_match_len] != pLookahead[hist_match_len])
-                        break;
+                  hist_match_len = count_matching_bytes(pComp, pLookahead, 0, max_admissable_match_len);
                }
 
                if (hist_match_len >= match_hist_min_match_len)
@@ -984,9 +1108,7 @@ namespace lzham
                const uint comp_pos = static_cast<uint>((m_accel.m_lookahead_pos + cur_lookahead_ofs - dist) & m_accel.m_max_dict_size_mask);
                const uint8* pComp = &m_accel.m_dict[comp_pos];
 
-               for (hist_match_len = 0; hist_match_len < max_admissable_match_len; hist_match_len++)
-                  if (pComp[hist_match_len] != pLookahead[hist_match_len])
-                     break;
+               hist_match_len = count_matching_bytes(pComp, pLookahead, 0, max_admissable_match_len);
             }
 
             if (hist_match_len >= match_hist_min_match_len)
@@ -1393,6 +1515,83 @@ namespace lzham
       return true;
    }
 
+   // Codes the rest of the block with a greedy parse, using the match accelerator's hash chains instead of the match finder.
+   // Each position takes the longest rep match, unless a hash chain match is at least 2 bytes longer (full matches cost more).
+   // After a long run of literals (i.e., incompressible data), the hash chains are only searched at every few positions.
+   // If the output is still no smaller than the input after the first few KB, the rest of the block is skipped and gave_up
+   // is set, since the block will be sent raw anyway and coding literals costs more than finding matches.
+   bool lzcompressor::hash_chain_parse(uint& cur_dict_ofs, uint& bytes_to_match, bool& gave_up)
+   {
+      const uint cGiveUpCheckInterval = 8192;
+      const uint block_len = bytes_to_match;
+      uint next_give_up_check = cGiveUpCheckInterval * 2;
+
+      gave_up = false;
+
+      uint num_lits = 0;
+      while (bytes_to_match)
+      {
+#if !defined(LZHAM_DISABLE_RAW_BLOCKS)
+         const uint bytes_coded = block_len - bytes_to_match;
+         if (bytes_coded >= next_give_up_check)
+         {
+            if (m_codec.get_encoding_buf().size() >= bytes_coded)
+            {
+               m_accel.advance_bytes(bytes_to_match);
+               cur_dict_ofs += bytes_to_match;
+               bytes_to_match = 0;
+               gave_up = true;
+               break;
+            }
+            next_give_up_check = bytes_coded + cGiveUpCheckInterval;
+         }
+#endif
+
+         const uint max_match_len = LZHAM_MIN(static_cast<uint>(CLZBase::cMaxHugeMatchLen), bytes_to_match);
+         const uint lookahead_pos = m_accel.get_lookahead_pos();
+
+         uint rep_len = 0;
+         int rep_index = 0;
+         for (uint i = 0; i < cMatchHistSize; i++)
+         {
+            uint hist_match_len = m_accel.get_match_len(0, m_state.m_match_hist[i], max_match_len);
+            if (hist_match_len > rep_len)
+            {
+               rep_len = hist_match_len;
+               rep_index = i;
+            }
+         }
+
+         const uint search_interval = LZHAM_MIN(1U + (num_lits >> 6), 32U);
+
+         uint match_len = 0, match_dist = 0;
+         if ((rep_len < m_settings.m_fast_bytes) && ((num_lits % search_interval) == 0))
+            match_len = m_accel.find_hash_chain_match(max_match_len, m_settings.m_fast_bytes, match_dist);
+         else if (search_interval == 1)
+            m_accel.insert_hash_chain(lookahead_pos);
+
+         // Short matches far away usually cost more than the literals.
+         if ((match_len == CLZBase::cMinMatchLen + 1) && (match_dist >= 16384))
+            match_len = 0;
+
+         lzdecision dec(cur_dict_ofs, 0, 0);
+         if ((match_len >= (CLZBase::cMinMatchLen + 1)) && (match_len >= (rep_len + 2)))
+            dec.init(cur_dict_ofs, match_len, match_dist);
+         else if (rep_len >= CLZBase::cMinMatchLen)
+            dec.init(cur_dict_ofs, rep_len, -(rep_index + 1));
+
+         num_lits = dec.is_lit() ? (num_lits + 1) : 0;
+
+         if (!code_decision(dec, cur_dict_ofs, bytes_to_match))
+            return false;
+
+         for (uint i = 1; i < dec.get_len(); i++)
+            m_accel.insert_hash_chain(lookahead_pos + i);
+      }
+
+      return true;
+   }
+
    bool lzcompressor::compress_block(const void* pBuf, uint buf_len)
    {
       uint cur_ofs = 0;
@@ -1476,17 +1675,34 @@ namespace lzham
 
       m_src_size += buf_len;
 
+      uint64 stage_start_time = get_time_ns();
+
       // Important: Don't do any expensive work until after add_bytes_begin() is called, to increase parallelism.
       if (!m_accel.add_bytes_begin(buf_len, static_cast<const uint8*>(pBuf)))
          return false;
 
-      m_start_of_block_state = m_state;
+      m_perf_stats.m_match_finder_ns += get_time_ns() - stage_start_time;
+      utils::zero_object(m_block_decision_counts);
+
+      if (m_reset_state_pending)
+      {
+         m_state = m_initial_state;
+         m_reset_state_pending = false;
+      }
 
-      m_src_adler32 = adler32(pBuf, buf_len, m_src_adler32);
-      m_src_crc32 = crc32(m_src_adler32, (const lzham_uint8*)pBuf, buf_len);
+      // The CRC is seeded with the updated Adler-32 of each block, so compute the block's CRC on its own in the same
+      // pass, then combine it with the seed.
+      uint block_crc32 = cInitCRC32;
+      adler32_crc32(pBuf, buf_len, &m_src_adler32, &block_crc32);
+      m_src_crc32 = crc32_combine(m_src_adler32, block_crc32, buf_len);
 
       m_block_start_dict_ofs = m_accel.get_lookahead_pos() & (m_accel.get_max_dict_size() - 1);
 
+      if ((buf_len <= cTinyBlockSize) && (m_params.m_compression_level != cCompressionLevelGreedy))
+         return compress_tiny_block_internal(buf_len);
+
+      m_start_of_block_state = m_state;
+
       uint cur_dict_ofs = m_block_start_dict_ofs;
 
       uint bytes_to_match = buf_len;
@@ -1538,12 +1754,23 @@ namespace lzham
       if (emit_reset_update_rate_command)
          m_state.reset_update_rate();
 
-      m_codec.encode_bits(emit_reset_update_rate_command ? 1 : 0, cBlockFlushTypeBits);
+      m_codec.encode_bits(m_reset_tables_pending ? 2 : (emit_reset_update_rate_command ? 1 : 0), cBlockFlushTypeBits);
 
       //coding_stats initial_stats(m_stats);
 
       uint initial_step = m_step;
 
+      bool hash_chain_gave_up = false;
+      if (m_params.m_compression_level == cCompressionLevelGreedy)
+      {
+         stage_start_time = get_time_ns();
+
+         if (!hash_chain_parse(cur_dict_ofs, bytes_to_match, hash_chain_gave_up))
+            return false;
+
+         m_perf_stats.m_parse_ns += get_time_ns() - stage_start_time;
+      }
+
       while (bytes_to_match)
       {
          const uint cAvgAcceptableGreedyMatchLen = 384;
@@ -1562,12 +1789,16 @@ namespace lzham
             greedy_parse_state.m_greedy_parse_gave_up = false;
             greedy_parse_state.m_greedy_parse_total_bytes_coded = 0;
 
+            stage_start_time = get_time_ns();
+
             if (!greedy_parse(greedy_parse_state))
             {
                if (!greedy_parse_state.m_greedy_parse_gave_up)
                   return false;
             }
 
+            m_perf_stats.m_parse_ns += get_time_ns() - stage_start_time;
+
             uint num_greedy_decisions_to_code = 0;
 
             const lzham::vector<lzdecision> &best_decisions = greedy_parse_state.m_best_decisions;
@@ -1654,6 +1885,8 @@ namespace lzham
             parse_thread_total_size = LZHAM_MIN(parse_thread_total_size, 1536);
          }
 
+         stage_start_time = get_time_ns();
+
          uint parse_thread_remaining = parse_thread_total_size;
          for (uint parse_thread_index = 0; parse_thread_index < num_parse_jobs; parse_thread_index++)
          {
@@ -1714,6 +1947,8 @@ namespace lzham
             }
          }
 
+         m_perf_stats.m_parse_ns += get_time_ns() - stage_start_time;
+
          {
             for (uint parse_thread_index = 0; parse_thread_index < num_parse_jobs; parse_thread_index++)
             {
@@ -1777,10 +2012,14 @@ namespace lzham
          }
       }
 
+      stage_start_time = get_time_ns();
+
       {
          m_accel.add_bytes_end();
       }
 
+      m_perf_stats.m_match_finder_ns += get_time_ns() - stage_start_time;
+
       if (!m_state.encode_eob(m_codec, m_accel, cur_dict_ofs))
          return false;
 
@@ -1788,10 +2027,13 @@ namespace lzham
          if (!m_codec.stop_encoding(true)) return false;
       }
 
+      m_perf_stats.m_table_rebuilds += m_codec.get_total_model_updates();
+
       // Coded the entire block - now see if it makes more sense to just send a raw/uncompressed block.
 
       uint compressed_size = m_codec.get_encoding_buf().size();
       LZHAM_NOTE_UNUSED(compressed_size);
+      LZHAM_NOTE_UNUSED(hash_chain_gave_up);
 
       bool used_raw_block = false;
 
@@ -1799,7 +2041,7 @@ namespace lzham
    #if (defined(LZHAM_DISABLE_RAW_BLOCKS))
        if (0)
    #else
-       if (compressed_size >= buf_len)
+       if ((hash_chain_gave_up) || (compressed_size >= buf_len))
    #endif
 #endif
       {
@@ -1808,64 +2050,220 @@ namespace lzham
          m_step = initial_step;
          //m_stats = initial_stats;
 
-         m_codec.reset();
-
-         if (!m_codec.start_encoding(buf_len + 16))
+         if (!code_raw_block(buf_len))
             return false;
 
-         if (!m_block_index)
-         {
-            if (!send_configuration())
-               return false;
-         }
+         used_raw_block = true;
+         emit_reset_update_rate_command = false;
+      }
 
-         if (!m_codec.encode_bits(cRawBlock, cBlockHeaderBits))
-            return false;
+      return end_block(buf_len, used_raw_block, emit_reset_update_rate_command);
+   }
 
-         LZHAM_ASSERT(buf_len <= 0x1000000);
-         if (!m_codec.encode_bits(buf_len - 1, 24))
+   // Blocks this small are dominated by the cost of copying the state for the parsers and the raw block fallback, so
+   // they're greedily parsed against the current state and coded directly instead. Since the state at the start of the
+   // block isn't saved, a block that doesn't compress is sent raw and followed by a reset of the models, which the next
+   // compressed block also tells the decompressor to do.
+   bool lzcompressor::compress_tiny_block_internal(uint buf_len)
+   {
+      uint cur_dict_ofs = m_block_start_dict_ofs;
+
+      uint bytes_to_match = buf_len;
+
+      m_state.start_of_block(m_accel, cur_dict_ofs, m_block_index);
+
+      uint64 stage_start_time = get_time_ns();
+
+      if (!tiny_block_parse(cur_dict_ofs, buf_len))
+         return false;
+
+      m_perf_stats.m_parse_ns += get_time_ns() - stage_start_time;
+
+      if (!m_codec.start_encoding((buf_len * 9) / 8))
+         return false;
+
+      if (!m_block_index)
+      {
+         if (!send_configuration())
             return false;
+      }
+
+      if (!m_codec.encode_bits(cCompBlock, cBlockHeaderBits))
+         return false;
+
+      if (!m_codec.encode_arith_init())
+         return false;
+
+      m_codec.encode_bits(m_reset_tables_pending ? 2 : 0, cBlockFlushTypeBits);
+
+      const lzham::vector<lzdecision> &best_decisions = m_parse_thread_state[0].m_best_decisions;
+
+      for (uint i = 0; i < best_decisions.size(); i++)
+      {
+         LZHAM_ASSERT(best_decisions[i].m_pos == (int)cur_dict_ofs);
 
-         // Write buf len check bits, to help increase the probability of detecting corrupted data more early.
-         uint buf_len0 = (buf_len - 1) & 0xFF;
-         uint buf_len1 = ((buf_len - 1) >> 8) & 0xFF;
-         uint buf_len2 = ((buf_len - 1) >> 16) & 0xFF;
-         if (!m_codec.encode_bits((buf_len0 ^ buf_len1) ^ buf_len2, 8))
+#if LZHAM_UPDATE_STATS
+         bit_cost_t cost = m_state.get_cost(*this, m_accel, best_decisions[i]);
+         m_stats.update(best_decisions[i], m_state, m_accel, cost);
+#endif
+
+         if (!code_decision(best_decisions[i], cur_dict_ofs, bytes_to_match))
             return false;
+      }
+
+      LZHAM_ASSERT(!bytes_to_match);
+
+      stage_start_time = get_time_ns();
+
+      m_accel.add_bytes_end();
+
+      m_perf_stats.m_match_finder_ns += get_time_ns() - stage_start_time;
+
+      if (!m_state.encode_eob(m_codec, m_accel, cur_dict_ofs))
+         return false;
+
+      if (!m_codec.stop_encoding(true))
+         return false;
+
+      m_perf_stats.m_table_rebuilds += m_codec.get_total_model_updates();
+
+      bool used_raw_block = false;
+
+#if !LZHAM_FORCE_ALL_RAW_BLOCKS
+   #if (defined(LZHAM_DISABLE_RAW_BLOCKS))
+       if (0)
+   #else
+       if (m_codec.get_encoding_buf().size() >= buf_len)
+   #endif
+#endif
+      {
+         m_reset_state_pending = true;
+         m_reset_tables_pending = true;
 
-         if (!m_codec.encode_align_to_byte())
+         if (!code_raw_block(buf_len))
             return false;
 
-         const uint8* pSrc = m_accel.get_ptr(m_block_start_dict_ofs);
+         used_raw_block = true;
+      }
+
+      return end_block(buf_len, used_raw_block, false);
+   }
+
+   // Greedily parses a tiny block using the current state's costs, without coding anything. The decisions are left in the
+   // first parse thread's best decisions.
+   bool lzcompressor::tiny_block_parse(uint cur_dict_ofs, uint bytes_to_parse)
+   {
+      parse_thread_state &parse_state = m_parse_thread_state[0];
+
+      lzham::vector<lzpriced_decision> &decisions = parse_state.m_temp_decisions;
+
+      if (!parse_state.m_best_decisions.try_resize(0))
+         return false;
+
+      state_base saved_state;
+      m_state.save_partial_state(saved_state);
 
-         for (uint i = 0; i < buf_len; i++)
+      bool status = true;
+
+      uint cur_ofs = 0;
+      while (cur_ofs < bytes_to_parse)
+      {
+         const uint max_admissable_match_len = LZHAM_MIN(static_cast<uint>(CLZBase::cMaxHugeMatchLen), bytes_to_parse - cur_ofs);
+
+         int largest_dec_index = enumerate_lz_decisions(cur_dict_ofs, m_state, decisions, 1, max_admissable_match_len);
+         if (largest_dec_index < 0)
          {
-            if (!m_codec.encode_bits(*pSrc++, 8))
-               return false;
+            status = false;
+            break;
          }
 
-         if (!m_codec.stop_encoding(true))
+         const lzpriced_decision &dec = decisions[largest_dec_index];
+
+         if (!parse_state.m_best_decisions.try_push_back(dec))
+         {
+            status = false;
+            break;
+         }
+
+         m_state.partial_advance(dec);
+
+         cur_dict_ofs += dec.get_len();
+         cur_ofs += dec.get_len();
+      }
+
+      m_state.restore_partial_state(saved_state);
+
+      return status;
+   }
+
+   bool lzcompressor::code_raw_block(uint buf_len)
+   {
+      m_codec.reset();
+
+      if (!m_codec.start_encoding(buf_len + 16))
+         return false;
+
+      if (!m_block_index)
+      {
+         if (!send_configuration())
             return false;
+      }
 
-         used_raw_block = true;
-         emit_reset_update_rate_command = false;
+      if (!m_codec.encode_bits(cRawBlock, cBlockHeaderBits))
+         return false;
+
+      LZHAM_ASSERT(buf_len <= 0x1000000);
+      if (!m_codec.encode_bits(buf_len - 1, 24))
+         return false;
+
+      // Write buf len check bits, to help increase the probability of detecting corrupted data more early.
+      uint buf_len0 = (buf_len - 1) & 0xFF;
+      uint buf_len1 = ((buf_len - 1) >> 8) & 0xFF;
+      uint buf_len2 = ((buf_len - 1) >> 16) & 0xFF;
+      if (!m_codec.encode_bits((buf_len0 ^ buf_len1) ^ buf_len2, 8))
+         return false;
+
+      if (!m_codec.encode_align_to_byte())
+         return false;
+
+      const uint8* pSrc = m_accel.get_ptr(m_block_start_dict_ofs);
+
+      for (uint i = 0; i < buf_len; i++)
+      {
+         if (!m_codec.encode_bits(*pSrc++, 8))
+            return false;
       }
 
+      return m_codec.stop_encoding(true);
+   }
+
+   bool lzcompressor::end_block(uint buf_len, bool used_raw_block, bool emit_reset_update_rate_command)
+   {
+      // Raw blocks don't have a flush type, so the reset stays pending until the next compressed block.
+      if (!used_raw_block)
+         m_reset_tables_pending = false;
+
       uint comp_size = m_codec.get_encoding_buf().size();
       uint scaled_ratio =  (comp_size * cBlockHistoryCompRatioScale) / buf_len;
       update_block_history(comp_size, buf_len, scaled_ratio, used_raw_block, emit_reset_update_rate_command);
 
+      m_perf_stats.m_src_bytes += buf_len;
+      if (used_raw_block)
+         m_perf_stats.m_raw_blocks++;
+      else
       {
-         if (m_comp_buf.empty())
-         {
-            m_comp_buf.swap(m_codec.get_encoding_buf());
-         }
-         else
-         {
-            if (!m_comp_buf.append(m_codec.get_encoding_buf()))
-               return false;
-         }
+         const decision_counts &counts = m_block_decision_counts;
+         m_perf_stats.m_compressed_blocks++;
+         m_perf_stats.m_literals += counts.m_literals;
+         m_perf_stats.m_delta_literals += counts.m_delta_literals;
+         for (uint i = 0; i < CLZBase::cMatchHistSize; i++)
+            m_perf_stats.m_rep_matches[i] += counts.m_rep_matches[i];
+         m_perf_stats.m_full_matches += counts.m_full_matches;
+         m_perf_stats.m_len2_matches += counts.m_len2_matches;
       }
+
+      if (!output_compressed_data(m_codec.get_encoding_buf()))
+         return false;
 #if LZHAM_UPDATE_STATS
       LZHAM_VERIFY(m_stats.m_total_bytes == m_src_size);
       if (emit_reset_update_rate_command)
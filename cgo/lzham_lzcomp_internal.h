@@ -10,7 +10,8 @@ namespace lzham
    typedef lzham::vector<uint8> byte_vec;
 
    const uint cMaxParseGraphNodes = 3072;
-   const uint cMaxParseThreads = 8;
+   const uint cMaxParseThreads = 1; // parsing is single-threaded so the output doesn't depend on the thread count; each parse thread state is ~800KB
+   const uint cTinyBlockSize = 256; // blocks up to this size are greedily parsed or sent raw (see compress_tiny_block_internal)
 
    enum compression_level
    {
@@ -19,6 +20,7 @@ namespace lzham
       cCompressionLevelDefault,
       cCompressionLevelBetter,
       cCompressionLevelUber,
+      cCompressionLevelGreedy, // hash chains and greedy parsing, faster than cCompressionLevelFastest
 
       cCompressionLevelCount
    };
@@ -87,12 +89,30 @@ namespace lzham
 
       bool put_bytes(const void* pBuf, uint buf_len);
 
+      // Chunked compression, for streams made by concatenating independently compressed chunks (see lzham_compress_memory_chunk).
+      // begin_chunk() is called after reset() for each chunk after the first, with the Adler-32 of the data in the earlier chunks.
+      // end_chunk() is called instead of put_bytes(NULL, 0) for each chunk before the last.
+      void begin_chunk(uint adler32);
+      bool end_chunk();
+
       const byte_vec& get_compressed_data() const   { return m_comp_buf; }
             byte_vec& get_compressed_data()         { return m_comp_buf; }
 
+      // Compressed data normally accumulates in m_comp_buf. After set_output_buf(), any data already in m_comp_buf is moved
+      // to pBuf, and each finished block is copied straight to it instead. Compression fails (and get_output_buf_overflow()
+      // returns true) as soon as a block doesn't fit. reset() goes back to using m_comp_buf.
+      bool set_output_buf(uint8* pBuf, size_t buf_size);
+      size_t get_output_buf_ofs() const { return m_out_buf_ofs; }
+      bool get_output_buf_overflow() const { return m_out_buf_overflow; }
+
       uint32 get_src_adler32() const { return m_src_adler32; }
       uint32 get_src_crc32() const { return m_src_crc32; }
 
+      // Statistics since the last reset() (see lzham_compress_get_stats). The match finder and parser times, the block and
+      // decision counts, and the table rebuilds are updated by the compressor; the caller adds the total time and allocations.
+      const lzham_compress_stats& get_perf_stats() const { return m_perf_stats; }
+            lzham_compress_stats& get_perf_stats()       { return m_perf_stats; }
+
    private:
       class state;
       
@@ -354,15 +374,37 @@ namespace lzham
 
       coding_stats m_stats;
 
+      // Decisions coded in the current block, which are added to m_perf_stats by end_block() unless the block is stored instead.
+      struct decision_counts
+      {
+         uint m_literals;
+         uint m_delta_literals;
+         uint m_rep_matches[CLZBase::cMatchHistSize];
+         uint m_full_matches;
+         uint m_len2_matches;
+      };
+
+      lzham_compress_stats m_perf_stats;
+      decision_counts m_block_decision_counts;
+
       byte_vec m_block_buf;
       byte_vec m_comp_buf;
 
+      uint8* m_pOut_buf;
+      size_t m_out_buf_size;
+      size_t m_out_buf_ofs;
+      bool m_out_buf_overflow;
+
       uint m_step;
 
       uint m_block_start_dict_ofs;
 
       uint m_block_index;
 
+      bool m_continue_stream;      // compressing a chunk after the first (see begin_chunk)
+      bool m_reset_tables_pending; // the next compressed block must tell the decompressor to reset its tables
+      bool m_reset_state_pending;  // m_state must be copied from m_initial_state before the next block is coded
+
       bool m_finished;
       bool m_use_task_pool;
             
@@ -409,6 +451,8 @@ namespace lzham
       
       state m_state;                            // main thread's current coding state
 
+      state m_initial_state;                    // freshly initialized state, copied on reset instead of regenerating the initial codes
+
       struct raw_parse_thread_state
       {
          uint m_start_ofs;
@@ -461,6 +505,7 @@ namespace lzham
       uint get_total_recent_reset_update_rate();
       
       bool send_zlib_header();
+      bool output_compressed_data(byte_vec& buf);
       bool init_seed_bytes();
       bool send_final_block();
       bool send_configuration();
@@ -468,9 +513,14 @@ namespace lzham
       bool optimal_parse(parse_thread_state &parse_state);
       int enumerate_lz_decisions(uint ofs, const state& cur_state, lzham::vector<lzpriced_decision>& decisions, uint min_match_len, uint max_match_len);
       bool greedy_parse(parse_thread_state &parse_state);
+      bool hash_chain_parse(uint& cur_dict_ofs, uint& bytes_to_match, bool& gave_up);
       void parse_job_callback(uint64 data, void* pData_ptr);
       bool compress_block(const void* pBuf, uint buf_len);
       bool compress_block_internal(const void* pBuf, uint buf_len);
+      bool compress_tiny_block_internal(uint buf_len);
+      bool tiny_block_parse(uint cur_dict_ofs, uint bytes_to_parse);
+      bool code_raw_block(uint buf_len);
+      bool end_block(uint buf_len, bool used_raw_block, bool emit_reset_update_rate_command);
       bool code_decision(lzdecision lzdec, uint& cur_ofs, uint& bytes_to_match);
       bool send_sync_block(lzham_flush_t flush_type);
    };
@@ -25,11 +25,15 @@ namespace lzham
    static const uint s_huge_match_base_len[4] = { CLZDecompBase::cMaxMatchLen + 1, CLZDecompBase::cMaxMatchLen + 1 + 256, CLZDecompBase::cMaxMatchLen + 1 + 256 + 1024, CLZDecompBase::cMaxMatchLen + 1 + 256 + 1024 + 4096 };
    static const uint8 s_huge_match_code_len[4] = { 8, 10, 12, 16 };
 
+   // A valid stream never needs more zero padding past the end of the input than fits in the codec's bit buffer. Beyond this, a truncated stream
+   // would be decoded from zeros forever in buffered mode (unbuffered mode eventually fails with LZHAM_DECOMP_STATUS_FAILED_DEST_BUF_TOO_SMALL).
+   const uint cMaxDecodePaddingBytes = 64;
+
    struct lzham_decompressor
    {
       void init();
       
-      template<bool unbuffered> lzham_decompress_status_t decompress();
+      template<bool unbuffered, bool collect_stats> lzham_decompress_status_t decompress();
       
       void reset_all_tables();
       void reset_huffman_table_update_rates();
@@ -57,6 +61,11 @@ namespace lzham
       lzham_decompress_params m_params;
 
       lzham_decompress_status_t m_status;
+
+      lzham_decompress_stats m_perf_stats; // since init() (see lzham_decompress_get_stats)
+
+      // Everything is allocated with this, including the state itself (the allocator can't be changed by lzham_decompress_reinit).
+      context_allocator m_allocator;
       
 #if LZHAM_USE_ALL_ARITHMETIC_CODING
       typedef adaptive_arith_data_model sym_data_model;
@@ -187,8 +196,7 @@ namespace lzham
                const uint cBytesToMemCpyPerIteration = 8192U; \
                size_t bytes_to_copy = LZHAM_MIN((size_t)(m_flush_n - copy_ofs), cBytesToMemCpyPerIteration); \
                LZHAM_MEMCPY(m_pOut_buf + copy_ofs, m_pFlush_src + copy_ofs, bytes_to_copy); \
-               m_decomp_adler32 = adler32(m_pFlush_src + copy_ofs, bytes_to_copy, m_decomp_adler32); \
-               m_decomp_crc32 = crc32(m_decomp_crc32, m_pFlush_src + copy_ofs, bytes_to_copy); \
+               adler32_crc32(m_pFlush_src + copy_ofs, bytes_to_copy, &m_decomp_adler32, &m_decomp_crc32); \
                copy_ofs += bytes_to_copy; \
             } \
          } \
@@ -206,6 +214,20 @@ namespace lzham
    #else
       #define LZHAM_DECOMPRESS_DECODE_ADAPTIVE_SYMBOL(codec, result, model) LZHAM_SYMBOL_CODEC_DECODE_ADAPTIVE_HUFFMAN(codec, result, model)
    #endif
+
+   // Counts and times the table rebuilds when decompress() is collecting statistics (collect_stats is a template parameter, so this is
+   // just the update otherwise).
+   #undef LZHAM_SYMBOL_CODEC_DECODE_UPDATE_MODEL
+   #define LZHAM_SYMBOL_CODEC_DECODE_UPDATE_MODEL(pModel) \
+      if (collect_stats) \
+      { \
+         const uint64 update_start_time = get_time_ns(); \
+         pModel->update(); \
+         m_perf_stats.m_table_rebuilds++; \
+         m_perf_stats.m_table_rebuild_ns += get_time_ns() - update_start_time; \
+      } \
+      else \
+         pModel->update()
    
    //------------------------------------------------------------------------------------------------------------------
    void lzham_decompressor::init()
@@ -240,6 +262,11 @@ namespace lzham
       m_z_dict_adler32 = 0;
 
       m_tmp = 0;
+
+      // Otherwise the padding byte count left by a truncated input fails the next stream (see lzham_lib_decompress).
+      m_codec.reset();
+
+      utils::zero_object(m_perf_stats);
    }
 
    void lzham_decompressor::reset_all_tables()
@@ -297,7 +324,7 @@ namespace lzham
    //------------------------------------------------------------------------------------------------------------------
    // Decompression method. Implemented as a coroutine so it can be paused and resumed to support streaming.
    //------------------------------------------------------------------------------------------------------------------
-   template<bool unbuffered>
+   template<bool unbuffered, bool collect_stats>
    lzham_decompress_status_t lzham_decompressor::decompress()
    {
       // Important: This function is a coroutine. ANY locals variables that need to be preserved across coroutine
@@ -467,12 +494,25 @@ namespace lzham
 
                dst_ofs = 0;
             }
+            else if ((!unbuffered) && (dst_ofs > m_seed_bytes_to_ignore_when_flushing))
+            {
+               // Also give the caller the output decoded since the last flush for sync flushes, so a stream can be read up to
+               // the flush without more input. The dictionary can't be reset, so the flushed bytes are skipped like seed bytes
+               // by the next flush.
+               LZHAM_SYMBOL_CODEC_DECODE_END(codec);
+               LZHAM_FLUSH_OUTPUT_BUFFER(dst_ofs);
+               LZHAM_SYMBOL_CODEC_DECODE_BEGIN(codec);
+
+               m_seed_bytes_to_ignore_when_flushing = dst_ofs;
+            }
          }
          else if (m_block_type == CLZDecompBase::cRawBlock)
          {
             // Raw block handling is complex because we ultimately want to (safely) handle as many bytes as possible using a small number of memcpy()'s.
             uint num_raw_bytes_remaining;
             num_raw_bytes_remaining = 0;
+
+            m_perf_stats.m_raw_blocks++;
             
 #undef LZHAM_SAVE_LOCAL_STATE
 #undef LZHAM_RESTORE_LOCAL_STATE
@@ -603,6 +643,8 @@ namespace lzham
          }
          else if (m_block_type == CLZDecompBase::cCompBlock)
          {
+            m_perf_stats.m_compressed_blocks++;
+
             LZHAM_SYMBOL_CODEC_DECODE_ARITH_START(codec)
 
             match_hist0 = 1;
@@ -653,6 +695,9 @@ namespace lzham
                      pDst[dst_ofs] = static_cast<uint8>(r);
                      prev_prev_char = prev_char;
                      prev_char = r;
+
+                     if (collect_stats)
+                        m_perf_stats.m_literals++;
                   }
                   else
                   {
@@ -679,6 +724,9 @@ namespace lzham
                      prev_prev_char = prev_char;
                      prev_char = r;
 
+                     if (collect_stats)
+                        m_perf_stats.m_delta_literals++;
+
 #undef LZHAM_SAVE_LOCAL_STATE
 #undef LZHAM_RESTORE_LOCAL_STATE
 #define LZHAM_SAVE_LOCAL_STATE
@@ -718,6 +766,9 @@ namespace lzham
                         if (LZHAM_BUILTIN_EXPECT(is_rep0_len1, 1))
                         {
                            cur_state = (cur_state < CLZDecompBase::cNumLitStates) ? 9 : 11;
+
+                           if (collect_stats)
+                              m_perf_stats.m_rep_matches[0]++;
                         }
                         else
                         {
@@ -740,6 +791,9 @@ namespace lzham
                            }
 
                            cur_state = (cur_state < CLZDecompBase::cNumLitStates) ? 8 : 11;
+
+                           if (collect_stats)
+                              m_perf_stats.m_rep_matches[0]++;
                         }
                      }
                      else
@@ -768,6 +822,9 @@ namespace lzham
                            uint temp = match_hist1;
                            match_hist1 = match_hist0;
                            match_hist0 = temp;
+
+                           if (collect_stats)
+                              m_perf_stats.m_rep_matches[1]++;
                         }
                         else
                         {
@@ -780,6 +837,9 @@ namespace lzham
                               match_hist2 = match_hist1;
                               match_hist1 = match_hist0;
                               match_hist0 = temp;
+
+                              if (collect_stats)
+                                 m_perf_stats.m_rep_matches[2]++;
                            }
                            else
                            {
@@ -789,6 +849,9 @@ namespace lzham
                               match_hist2 = match_hist1;
                               match_hist1 = match_hist0;
                               match_hist0 = temp;
+
+                              if (collect_stats)
+                                 m_perf_stats.m_rep_matches[3]++;
                            }
                         }
 
@@ -888,6 +951,13 @@ namespace lzham
                      match_hist1 = match_hist0;
                      match_hist0 = m_lzBase.m_lzx_position_base[match_slot] + extra_bits;
 
+                     if (collect_stats)
+                     {
+                        m_perf_stats.m_full_matches++;
+                        if (match_len == CLZDecompBase::cMinMatchLen)
+                           m_perf_stats.m_len2_matches++;
+                     }
+
                      cur_state = (cur_state < CLZDecompBase::cNumLitStates) ? CLZDecompBase::cNumLitStates : CLZDecompBase::cNumLitStates + 3;
 
 #undef LZHAM_SAVE_LOCAL_STATE
@@ -1034,13 +1104,27 @@ namespace lzham
          uint l; LZHAM_SYMBOL_CODEC_DECODE_GET_BITS(codec, l, 16);
          m_file_src_file_adler32 = (m_file_src_file_adler32 << 16) | l;
 
-         if (m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_COMPUTE_ADLER32)
+         if (unbuffered)
          {
-            if (unbuffered)
+            const uint checksum_flags = m_params.m_decompress_flags & (LZHAM_DECOMP_FLAG_COMPUTE_ADLER32 | LZHAM_DECOMP_FLAG_COMPUTE_CRC32);
+            if (checksum_flags == (LZHAM_DECOMP_FLAG_COMPUTE_ADLER32 | LZHAM_DECOMP_FLAG_COMPUTE_CRC32))
+            {
+               m_decomp_adler32 = cInitAdler32;
+               m_decomp_crc32 = cInitCRC32;
+               adler32_crc32(pDst, dst_ofs, &m_decomp_adler32, &m_decomp_crc32);
+            }
+            else if (checksum_flags == LZHAM_DECOMP_FLAG_COMPUTE_ADLER32)
             {
                m_decomp_adler32 = adler32(pDst, dst_ofs, cInitAdler32);
             }
+            else if (checksum_flags == LZHAM_DECOMP_FLAG_COMPUTE_CRC32)
+            {
+               m_decomp_crc32 = crc32(cInitCRC32, pDst, dst_ofs);
+            }
+         }
 
+         if (m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_COMPUTE_ADLER32)
+         {
             if (m_file_src_file_adler32 != m_decomp_adler32)
             {
                m_status = LZHAM_DECOMP_STATUS_FAILED_ADLER32;
@@ -1050,14 +1134,7 @@ namespace lzham
          {
              m_decomp_adler32 = m_file_src_file_adler32;
          }
-         if (m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_COMPUTE_CRC32)
-         {
-             if (unbuffered)
-             {
-                 m_decomp_crc32 = crc32(cInitCRC32, pDst, dst_ofs);
-             }
-         }
-         else
+         if (0 == (m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_COMPUTE_CRC32))
          {
              m_decomp_crc32 = m_file_src_file_crc32;
          }
@@ -1106,12 +1183,22 @@ namespace lzham
 
       if (!check_params(pParams))
          return NULL;
+
+      context_allocator allocator;
+      if (!allocator.init(pParams->m_pRealloc, pParams->m_pMSize, pParams->m_pAlloc_user_data, (pParams->m_decompress_flags & LZHAM_DECOMP_FLAG_USE_ARENA) != 0))
+         return NULL;
+
+      memory_scope scope(&allocator.m_allocator);
       
       lzham_decompressor *pState = lzham_new<lzham_decompressor>();
       if (!pState)
+      {
+         allocator.deinit();
          return NULL;
+      }
 
       pState->m_params = *pParams;
+      pState->m_allocator = allocator;
 
       if (pState->m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED)
       {
@@ -1126,6 +1213,7 @@ namespace lzham
          if (!pState->m_pRaw_decomp_buf)
          {
             lzham_delete(pState);
+            allocator.deinit();
             return NULL;
          }
          pState->m_raw_decomp_buf_size = decomp_buf_size;
@@ -1146,8 +1234,11 @@ namespace lzham
 
       if (!check_params(pParams))
          return NULL;
+
+      memory_scope scope(&pState->m_allocator.m_allocator);
       
-      if (pState->m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED)
+      // Use the new params, so the decompressor can be switched between buffered and unbuffered mode.
+      if (pParams->m_decompress_flags & LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED)
       {
          lzham_free(pState->m_pRaw_decomp_buf);
          pState->m_pRaw_decomp_buf = NULL;
@@ -1156,7 +1247,7 @@ namespace lzham
       }
       else
       {
-         uint32 new_dict_size = 1U << pState->m_params.m_dict_size_log2;
+         uint32 new_dict_size = 1U << pParams->m_dict_size_log2;
          if ((!pState->m_pRaw_decomp_buf) || (pState->m_raw_decomp_buf_size < new_dict_size))
          {
             uint8 *pNew_dict = static_cast<uint8*>(lzham_realloc(pState->m_pRaw_decomp_buf, new_dict_size + 15));
@@ -1186,8 +1277,13 @@ namespace lzham
       checksums->adler32 = pState->m_decomp_adler32;
       checksums->crc32 = pState->m_decomp_crc32;
 
-      lzham_free(pState->m_pRaw_decomp_buf);
-      lzham_delete(pState);
+      context_allocator allocator(pState->m_allocator);
+      {
+         memory_scope scope(&allocator.m_allocator);
+         lzham_free(pState->m_pRaw_decomp_buf);
+         lzham_delete(pState);
+      }
+      allocator.deinit();
 
       return checksums;
    }
@@ -1215,6 +1311,8 @@ namespace lzham
          return LZHAM_DECOMP_STATUS_INVALID_PARAMETER;
       }
 
+      memory_scope scope(&pState->m_allocator.m_allocator);
+
       pState->m_pIn_buf = pIn_buf;
       pState->m_pIn_buf_size = pIn_buf_size;
       pState->m_pOut_buf = pOut_buf;
@@ -1237,11 +1335,47 @@ namespace lzham
          }
       }
 
+      if (pState->m_codec.m_decode_padding_bytes > cMaxDecodePaddingBytes)
+      {
+         *pIn_buf_size = 0;
+         *pOut_buf_size = 0;
+         return LZHAM_DECOMP_STATUS_FAILED_EXPECTED_MORE_RAW_BYTES;
+      }
+
+      const uint64 start_time = get_time_ns();
+      const lzham_alloc_stats start_allocs = lzham_get_alloc_stats();
+
       lzham_decompress_status_t status;
-      if (pState->m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED)
-         status = pState->decompress<true>();
+      if (pState->m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_COLLECT_STATS)
+      {
+         if (pState->m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED)
+            status = pState->decompress<true, true>();
+         else
+            status = pState->decompress<false, true>();
+      }
       else
-         status = pState->decompress<false>();
+      {
+         if (pState->m_params.m_decompress_flags & LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED)
+            status = pState->decompress<true, false>();
+         else
+            status = pState->decompress<false, false>();
+      }
+
+      if ((status < LZHAM_DECOMP_STATUS_FIRST_SUCCESS_OR_FAILURE_CODE) && (pState->m_codec.m_decode_padding_bytes > cMaxDecodePaddingBytes))
+         status = LZHAM_DECOMP_STATUS_FAILED_EXPECTED_MORE_RAW_BYTES;
+
+      lzham_decompress_stats &stats = pState->m_perf_stats;
+      stats.m_total_ns += get_time_ns() - start_time;
+      if (status < LZHAM_DECOMP_STATUS_FIRST_FAILURE_CODE)
+      {
+         // The buffer sizes aren't always updated on failure.
+         stats.m_src_bytes += *pIn_buf_size;
+         stats.m_dst_bytes += *pOut_buf_size;
+      }
+      const lzham_alloc_stats &allocs = lzham_get_alloc_stats();
+      stats.m_bytes_allocated += allocs.m_bytes - start_allocs.m_bytes;
+      stats.m_allocs += allocs.m_allocs - start_allocs.m_allocs;
+      stats.m_underlying_allocs += allocs.m_underlying_allocs - start_allocs.m_underlying_allocs;
       
       return status;
    }
@@ -1266,10 +1400,45 @@ namespace lzham
       if (pCrc32)
           *pCrc32 = checksums->crc32;
 
+      delete checksums;
 
       return status;
    }
 
+   lzham_decompress_status_t LZHAM_CDECL lzham_lib_decompress_memory_reinit(lzham_decompress_state_ptr p, lzham_uint8* pDst_buf, size_t *pDst_len, const lzham_uint8* pSrc_buf, size_t src_len, lzham_uint32 *pAdler32, lzham_uint32 *pCrc32)
+   {
+      lzham_decompressor *pState = static_cast<lzham_decompressor *>(p);
+      if (!pState)
+         return LZHAM_DECOMP_STATUS_INVALID_PARAMETER;
+
+      lzham_decompress_params params(pState->m_params);
+      params.m_decompress_flags |= LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED;
+
+      // In unbuffered mode reinit() only resets the models, reusing the decoder tables allocated by previous calls.
+      if (!lzham_lib_decompress_reinit(pState, &params))
+         return LZHAM_DECOMP_STATUS_FAILED_INITIALIZING;
+
+      lzham_decompress_status_t status = lzham_lib_decompress(pState, pSrc_buf, &src_len, pDst_buf, pDst_len, true);
+
+      if (pAdler32)
+         *pAdler32 = pState->m_decomp_adler32;
+      if (pCrc32)
+          *pCrc32 = pState->m_decomp_crc32;
+
+      return status;
+   }
+
+   lzham_bool LZHAM_CDECL lzham_lib_decompress_get_stats(lzham_decompress_state_ptr p, lzham_decompress_stats *pStats)
+   {
+      lzham_decompressor *pState = static_cast<lzham_decompressor *>(p);
+      if ((!pState) || (!pStats) || (pStats->m_struct_size != sizeof(lzham_decompress_stats)))
+         return false;
+
+      *pStats = pState->m_perf_stats;
+      pStats->m_struct_size = sizeof(lzham_decompress_stats);
+      return true;
+   }
+
    // ----------------- zlib-style API's
 
    int LZHAM_CDECL lzham_lib_z_inflateInit(lzham_z_streamp pStream)
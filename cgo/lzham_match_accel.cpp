@@ -19,6 +19,7 @@ namespace lzham
       m_pLZBase(NULL),
       m_pTask_pool(NULL),
       m_max_helper_threads(0),
+      m_dict_size_limit(0),
       m_max_dict_size(0),
       m_max_dict_size_mask(0),
       m_lookahead_pos(0),
@@ -30,12 +31,13 @@ namespace lzham
       m_max_probes(0),
       m_max_matches(0),
       m_all_matches(false),
+      m_hash_chains(false),
       m_next_match_ref(0),
       m_num_completed_helper_threads(0)
    {
    }
 
-   bool search_accelerator::init(CLZBase* pLZBase, task_pool* pPool, uint max_helper_threads, uint max_dict_size, uint max_matches, bool all_matches, uint max_probes)
+   bool search_accelerator::init(CLZBase* pLZBase, task_pool* pPool, uint max_helper_threads, uint max_dict_size, uint max_matches, bool all_matches, uint max_probes, bool hash_chains)
    {
       LZHAM_ASSERT(pLZBase);
       LZHAM_ASSERT(max_dict_size && math::is_power_of_2(max_dict_size));
@@ -48,9 +50,9 @@ namespace lzham
       m_max_helper_threads = m_pTask_pool ? max_helper_threads : 0;
       m_max_matches = LZHAM_MIN(m_max_probes, max_matches);
       m_all_matches = all_matches;
+      m_hash_chains = hash_chains;
 
-      m_max_dict_size = max_dict_size;
-      m_max_dict_size_mask = m_max_dict_size - 1;
+      m_dict_size_limit = max_dict_size;
       m_cur_dict_size = 0;
       m_lookahead_size = 0;
       m_lookahead_pos = 0;
@@ -59,15 +61,12 @@ namespace lzham
       m_fill_dict_size = 0;
       m_num_completed_helper_threads = 0;
 
-      if (!m_dict.try_resize_no_construct(max_dict_size + LZHAM_MIN(m_max_dict_size, static_cast<uint>(CLZBase::cMaxHugeMatchLen))))
+      if (!resize_dict(LZHAM_MIN(static_cast<uint>(cMinDictSize), max_dict_size)))
          return false;
 
       if (!m_hash.try_resize_no_construct(cHashSize))
          return false;
 
-      if (!m_nodes.try_resize_no_construct(max_dict_size))
-         return false;
-
       memset(m_hash.get_ptr(), 0, m_hash.size_in_bytes());
 
       return true;
@@ -83,6 +82,9 @@ namespace lzham
       m_fill_dict_size = 0;
       m_num_completed_helper_threads = 0;
 
+      // Shrinking the window doesn't free anything, so reusing the accelerator for inputs of a similar size doesn't allocate.
+      resize_dict(LZHAM_MIN(static_cast<uint>(cMinDictSize), m_dict_size_limit));
+
       // Clearing the hash tables is only necessary for determinism (otherwise, it's possible the matches returned after a reset will depend on the data processes before the reset).
       if (m_hash.size()) 
          memset(m_hash.get_ptr(), 0, m_hash.size_in_bytes());
@@ -95,10 +97,30 @@ namespace lzham
       m_cur_dict_size = 0;
    }
 
+   // Returns the number of bytes which can be added before the full-size window wraps around, which is the same whether
+   // or not the current window has grown to the full size yet.
    uint search_accelerator::get_max_add_bytes() const
    {
-      uint add_pos = static_cast<uint>(m_lookahead_pos & (m_max_dict_size - 1));
-      return m_max_dict_size - add_pos;
+      uint add_pos = static_cast<uint>(m_lookahead_pos & (m_dict_size_limit - 1));
+      return m_dict_size_limit - add_pos;
+   }
+
+   bool search_accelerator::resize_dict(uint dict_size)
+   {
+      LZHAM_ASSERT(math::is_power_of_2(dict_size) && (dict_size <= m_dict_size_limit));
+
+      // Vectors keep their contents and capacity when resized, so growing the window before it has wrapped leaves every
+      // byte and node at the same offset.
+      if (!m_dict.try_resize_no_construct(dict_size + LZHAM_MIN(dict_size, static_cast<uint>(CLZBase::cMaxHugeMatchLen))))
+         return false;
+
+      if (!m_nodes.try_resize_no_construct(dict_size))
+         return false;
+
+      m_max_dict_size = dict_size;
+      m_max_dict_size_mask = dict_size - 1;
+
+      return true;
    }
 
    static uint8 g_hamming_dist[256] =
@@ -141,6 +163,8 @@ namespace lzham
 
       const uint8* pDict = m_dict.get_ptr();
 
+      uint run_start_pos = 0, run_end_pos = 0;
+
       while (fill_lookahead_size >= 3)
       {
          uint insert_pos = fill_lookahead_pos & m_max_dict_size_mask;
@@ -163,17 +187,58 @@ namespace lzham
 
          dict_match* pDstMatch = temp_matches;
 
+         const uint max_match_len = LZHAM_MIN(static_cast<uint>(CLZBase::cMaxMatchLen), fill_lookahead_size);
+
+         const uint8* pIns = &pDict[insert_pos];
+
+         // Track the run of identical bytes [run_start_pos, run_end_pos) containing this position, extending it incrementally so
+         // long runs cost O(1) per byte.
+         if ((fill_lookahead_pos > run_start_pos) && (fill_lookahead_pos < run_end_pos))
+         {
+            const uint ofs = run_end_pos - fill_lookahead_pos;
+            if (ofs < max_match_len)
+               run_end_pos += count_matching_bytes(pIns + ofs - 1, pIns + ofs, 0, max_match_len - ofs);
+         }
+         else if ((insert_pos) && (fill_dict_size > 1) && (pIns[-1] == pIns[0]) && (pIns[0] == c2))
+         {
+            run_start_pos = fill_lookahead_pos - 1;
+            run_end_pos = fill_lookahead_pos + count_matching_bytes(pIns - 1, pIns, 0, max_match_len);
+         }
+
+         // Inside a long run the tree degenerates, and every position is spent rediscovering the same match. If the previous byte and
+         // the next max_match_len bytes are all the same and the previous position heads this hash's tree, the first probe is a
+         // distance 1 match of max_match_len, so the search would return only that match and replace the previous node with this one.
+         // Do exactly that without walking the tree, so the matches and the tree are the same as before.
+         if ((fill_lookahead_pos > run_start_pos) && ((fill_lookahead_pos + max_match_len) <= run_end_pos) && (m_hash[h] == (fill_lookahead_pos - 1)))
+         {
+            m_hash[h] = static_cast<uint>(fill_lookahead_pos);
+
+            const node& prev_node = m_nodes[(fill_lookahead_pos - 1) & m_max_dict_size_mask];
+            m_nodes[insert_pos].m_left = prev_node.m_left;
+            m_nodes[insert_pos].m_right = prev_node.m_right;
+
+            pDstMatch->m_len = static_cast<uint16>(max_match_len - CLZBase::cMinMatchLen);
+            pDstMatch->m_dist = 1 | 0x80000000;
+
+            const uint match_ref_ofs = atomic_exchange_add(&m_next_match_ref, 1);
+            m_matches[match_ref_ofs] = *pDstMatch;
+
+            atomic_exchange32((atomic32_t*)&m_match_refs[static_cast<uint>(fill_lookahead_pos - m_fill_lookahead_pos)], match_ref_ofs);
+
+            fill_lookahead_pos++;
+            fill_lookahead_size--;
+            fill_dict_size++;
+            continue;
+         }
+
          uint cur_pos = m_hash[h];
          m_hash[h] = static_cast<uint>(fill_lookahead_pos);
 
          uint *pLeft = &m_nodes[insert_pos].m_left;
          uint *pRight = &m_nodes[insert_pos].m_right;
 
-         const uint max_match_len = LZHAM_MIN(static_cast<uint>(CLZBase::cMaxMatchLen), fill_lookahead_size);
          uint best_match_len = 2;
 
-         const uint8* pIns = &pDict[insert_pos];
-
          uint n = m_max_probes;
          for ( ; ; )
          {
@@ -189,36 +254,14 @@ namespace lzham
             node *pNode = &m_nodes[pos];
 
             // Unfortunately, the initial compare match_len must be 0 because of the way we hash and truncate matches at the end of each block.
-            uint match_len = 0;
             const uint8* pComp = &pDict[pos];
-
-#if LZHAM_PLATFORM_X360
-            for ( ; match_len < max_match_len; match_len++)
-               if (pComp[match_len] != pIns[match_len])
-                  break;
-#else
-            // Compare a qword at a time for a bit more efficiency.
-            const uint64* pComp_end = reinterpret_cast<const uint64*>(pComp + max_match_len - 7);
-            const uint64* pComp_cur = reinterpret_cast<const uint64*>(pComp);
-            const uint64* pIns_cur = reinterpret_cast<const uint64*>(pIns);
-            while (pComp_cur < pComp_end)
-            {
-               if (*pComp_cur != *pIns_cur)
-                  break;
-               pComp_cur++;
-               pIns_cur++;
-            }
-            uint alt_match_len = static_cast<uint>(reinterpret_cast<const uint8*>(pComp_cur) - reinterpret_cast<const uint8*>(pComp));
-            for ( ; alt_match_len < max_match_len; alt_match_len++)
-               if (pComp[alt_match_len] != pIns[alt_match_len])
-                  break;
+            uint match_len = count_matching_bytes(pComp, pIns, 0, max_match_len);
 #ifdef LZVERIFY
-            for ( ; match_len < max_match_len; match_len++)
-               if (pComp[match_len] != pIns[match_len])
+            uint slow_match_len;
+            for (slow_match_len = 0; slow_match_len < max_match_len; slow_match_len++)
+               if (pComp[slow_match_len] != pIns[slow_match_len])
                   break;
-            LZHAM_VERIFY(alt_match_len == match_len);
-#endif
-            match_len = alt_match_len;
+            LZHAM_VERIFY(slow_match_len == match_len);
 #endif
 
             if (match_len > best_match_len)
@@ -324,7 +367,8 @@ namespace lzham
          fill_dict_size++;
       }
 
-      while (fill_lookahead_size)
+      // The last couple of bytes aren't hashed, so they don't belong to any thread; only let the first one clear them.
+      while ((fill_lookahead_size) && (!thread_index))
       {
          uint insert_pos = fill_lookahead_pos & m_max_dict_size_mask;
          m_nodes[insert_pos].m_left = 0;
@@ -397,6 +441,14 @@ namespace lzham
 
    bool search_accelerator::find_all_matches(uint num_bytes)
    {
+      if (m_hash_chains)
+      {
+         m_fill_lookahead_pos = m_lookahead_pos;
+         m_fill_lookahead_size = num_bytes;
+         m_fill_dict_size = m_cur_dict_size;
+         return true;
+      }
+
       if (!m_matches.try_resize_no_construct(m_max_probes * num_bytes))
          return false;
 
@@ -465,16 +517,25 @@ namespace lzham
 
    bool search_accelerator::add_bytes_begin(uint num_bytes, const uint8* pBytes)
    {
-      LZHAM_ASSERT(num_bytes <= m_max_dict_size);
+      LZHAM_ASSERT(num_bytes <= get_max_add_bytes());
       LZHAM_ASSERT(!m_lookahead_size);
 
+      // The window hasn't wrapped around while it's smaller than the full size, so grow it to fit the new bytes.
+      bool resized_dict = false;
+      if ((m_max_dict_size < m_dict_size_limit) && ((m_lookahead_pos + num_bytes) > m_max_dict_size))
+      {
+         if (!resize_dict(LZHAM_MIN(math::next_pow2(m_lookahead_pos + num_bytes), m_dict_size_limit)))
+            return false;
+         resized_dict = true;
+      }
+
       uint add_pos = m_lookahead_pos & m_max_dict_size_mask;
       LZHAM_ASSERT((add_pos + num_bytes) <= m_max_dict_size);
 
       memcpy(&m_dict[add_pos], pBytes, num_bytes);
 
       uint dict_bytes_to_mirror = LZHAM_MIN(static_cast<uint>(CLZBase::cMaxHugeMatchLen), m_max_dict_size);
-      if (add_pos < dict_bytes_to_mirror)
+      if ((add_pos < dict_bytes_to_mirror) || (resized_dict))
          memcpy(&m_dict[m_max_dict_size], &m_dict[0], dict_bytes_to_mirror);
 
       m_lookahead_size = num_bytes;
@@ -509,7 +570,7 @@ namespace lzham
       // This may spin until the match finder job(s) catch up to the caller's lookahead position.
       for ( ; ; )
       {
-         match_ref = m_match_refs[match_ref_ofs];
+         match_ref = static_cast<int>(atomic_load32(&m_match_refs[match_ref_ofs]));
          if (match_ref == -2)
             return NULL;
          else if (match_ref != -1)
@@ -539,6 +600,73 @@ namespace lzham
       return &m_matches[match_ref];
    }
 
+   void search_accelerator::insert_hash_chain(uint pos)
+   {
+      // The last couple of bytes of each block can't be hashed (like with the tree).
+      if ((pos - m_fill_lookahead_pos + 3) > m_fill_lookahead_size)
+         return;
+
+      const uint insert_pos = pos & m_max_dict_size_mask;
+      const uint8* pIns = &m_dict[insert_pos];
+      const uint h = hash3_to_16(pIns[0], pIns[1], pIns[2]);
+
+      m_nodes[insert_pos].m_left = m_hash[h];
+      m_hash[h] = pos;
+   }
+
+   uint search_accelerator::find_hash_chain_match(uint max_match_len, uint nice_match_len, uint& match_dist)
+   {
+      LZHAM_ASSERT(m_hash_chains);
+      LZHAM_ASSERT(max_match_len <= m_lookahead_size);
+
+      const uint pos = m_lookahead_pos;
+      if (((pos - m_fill_lookahead_pos + 3) > m_fill_lookahead_size) || (max_match_len < CLZBase::cMinMatchLen + 1))
+      {
+         insert_hash_chain(pos);
+         return 0;
+      }
+
+      const uint insert_pos = pos & m_max_dict_size_mask;
+      const uint8* pIns = &m_dict[insert_pos];
+      const uint h = hash3_to_16(pIns[0], pIns[1], pIns[2]);
+
+      uint cur_pos = m_hash[h];
+      m_nodes[insert_pos].m_left = cur_pos;
+      m_hash[h] = pos;
+
+      nice_match_len = LZHAM_MIN(nice_match_len, max_match_len);
+
+      // Stale entries (from before a reset or flush, or overwritten by the window wrapping) are either outside the
+      // current dictionary or break the strictly increasing distances, which ends the search.
+      uint best_match_len = 0;
+      uint prev_delta_pos = 0;
+      for (uint n = m_max_probes; n; n--)
+      {
+         const uint delta_pos = pos - cur_pos;
+         if ((delta_pos <= prev_delta_pos) || (delta_pos > m_cur_dict_size))
+            break;
+
+         const uint comp_pos = cur_pos & m_max_dict_size_mask;
+         const uint8* pComp = &m_dict[comp_pos];
+         if (pComp[best_match_len] == pIns[best_match_len])
+         {
+            const uint len = count_matching_bytes(pComp, pIns, 0, max_match_len);
+            if (len > best_match_len)
+            {
+               best_match_len = len;
+               match_dist = delta_pos;
+               if (len >= nice_match_len)
+                  break;
+            }
+         }
+
+         prev_delta_pos = delta_pos;
+         cur_pos = m_nodes[comp_pos].m_left;
+      }
+
+      return best_match_len;
+   }
+
    void search_accelerator::advance_bytes(uint num_bytes)
    {
       LZHAM_ASSERT(num_bytes <= m_lookahead_size);
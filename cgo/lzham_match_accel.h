@@ -2,11 +2,67 @@
 // See Copyright Notice and license at the end of lzham.h
 #pragma once
 #include "lzham_lzbase.h"
+#if LZHAM_THREADING
+#include "lzham_pthreads_threading.h"
+#else
 #include "lzham_null_threading.h"
+#endif
+
+#if LZHAM_USE_UNALIGNED_INT_LOADS && defined(__GNUC__)
+   #if defined(__SSE2__)
+      #include <emmintrin.h>
+   #elif defined(__ARM_NEON) && defined(__aarch64__)
+      #include <arm_neon.h>
+   #endif
+#endif
 
 namespace lzham
 {
    const uint cMatchAccelMaxSupportedProbes = 128;
+
+   // Returns the number of bytes pA and pB have in common, starting at start_len and stopping at max_len. Nothing past
+   // max_len is read.
+   LZHAM_FORCE_INLINE uint count_matching_bytes(const uint8* pA, const uint8* pB, uint start_len, uint max_len)
+   {
+      uint len = start_len;
+
+#if LZHAM_USE_UNALIGNED_INT_LOADS && LZHAM_LITTLE_ENDIAN_CPU && defined(__GNUC__)
+   #if defined(__SSE2__)
+      while ((len + 16) <= max_len)
+      {
+         __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pA + len));
+         __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pB + len));
+         uint mask = static_cast<uint>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) ^ 0xFFFF;
+         if (mask)
+            return len + __builtin_ctz(mask);
+         len += 16;
+      }
+   #elif defined(__ARM_NEON) && defined(__aarch64__)
+      while ((len + 16) <= max_len)
+      {
+         uint8x16_t eq = vceqq_u8(vld1q_u8(pA + len), vld1q_u8(pB + len));
+         // Narrow each byte of the comparison to a nibble, giving a 64-bit mask.
+         uint64 mask = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+         if (mask)
+            return len + (__builtin_ctzll(mask) >> 2);
+         len += 16;
+      }
+   #endif
+      while ((len + 8) <= max_len)
+      {
+         uint64 x = *reinterpret_cast<const uint64*>(pA + len) ^ *reinterpret_cast<const uint64*>(pB + len);
+         if (x)
+            return len + (__builtin_ctzll(x) >> 3);
+         len += 8;
+      }
+#endif
+
+      for ( ; len < max_len; len++)
+         if (pA[len] != pB[len])
+            break;
+
+      return len;
+   }
       
    struct node
    {
@@ -38,7 +94,11 @@ namespace lzham
       // If all_matches is true, the match finder returns all found matches with no filtering.
       // Otherwise, the finder will tend to return lists of matches with mostly unique lengths.
       // For each length, it will discard matches with worse distances (in the coding sense).
-      bool init(CLZBase* pLZBase, task_pool* pPool, uint max_helper_threads, uint max_dict_size, uint max_matches, bool all_matches, uint max_probes);
+      // The dictionary window starts small and grows (up to max_dict_size) as bytes are added, until it wraps around. Until
+      // then it always holds everything added so far, so the matches found are the same as with a full-size window.
+      // If hash_chains is true, add_bytes_begin() doesn't find any matches. Instead, the caller finds them with
+      // find_hash_chain_match() while it parses, and inserts any positions it skips over with insert_hash_chain().
+      bool init(CLZBase* pLZBase, task_pool* pPool, uint max_helper_threads, uint max_dict_size, uint max_matches, bool all_matches, uint max_probes, bool hash_chains = false);
       
       void reset();
       void flush();
@@ -72,6 +132,12 @@ namespace lzham
       dict_match* find_matches(uint lookahead_ofs, bool spin = true);
             
       void advance_bytes(uint num_bytes);
+
+      // Hash chain match finding. insert_hash_chain() takes an absolute position within the lookahead.
+      // find_hash_chain_match() inserts the current lookahead position and returns the length of the longest match found
+      // (searching up to max_probes entries, or until a match at least nice_match_len long is found), or 0.
+      void insert_hash_chain(uint pos);
+      uint find_hash_chain_match(uint max_match_len, uint nice_match_len, uint& match_dist);
       
       LZHAM_FORCE_INLINE uint get_match_len(uint lookahead_ofs, int dist, uint max_match_len, uint start_match_len = 0) const
       {
@@ -89,12 +155,7 @@ namespace lzham
          const uint8* pComp = &m_dict[comp_pos];
          const uint8* pLookahead = &m_dict[lookahead_pos];
          
-         uint match_len;
-         for (match_len = start_match_len; match_len < max_match_len; match_len++)
-            if (pComp[match_len] != pLookahead[match_len])
-               break;
-
-         return match_len;
+         return count_matching_bytes(pComp, pLookahead, start_match_len, max_match_len);
       }
                   
    public:
@@ -102,6 +163,8 @@ namespace lzham
       task_pool* m_pTask_pool;
       uint m_max_helper_threads;
    
+      enum { cMinDictSize = 4096 };
+      uint m_dict_size_limit;
       uint m_max_dict_size;
       uint m_max_dict_size_mask;
       
@@ -114,7 +177,7 @@ namespace lzham
       
       enum { cHashSize = 65536 };
       lzham::vector<uint> m_hash;
-      lzham::vector<node> m_nodes;
+      lzham::vector<node> m_nodes; // in hash chain mode, m_left links each position to the previous one with the same hash
 
       lzham::vector<dict_match> m_matches;
       lzham::vector<atomic32_t> m_match_refs;
@@ -133,11 +196,13 @@ namespace lzham
       uint m_max_matches;
       
       bool m_all_matches;
+      bool m_hash_chains;
                   
       volatile atomic32_t m_next_match_ref;
       
       volatile atomic32_t m_num_completed_helper_threads;
                   
+      bool resize_dict(uint dict_size);
       void find_all_matches_callback(uint64 data, void* pData_ptr);
       bool find_all_matches(uint num_bytes);
       bool find_len2_matches();
@@ -4,6 +4,10 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#if LZHAM_THREADING
+#include <pthread.h>
+#endif
+
 using namespace lzham;
 
 #define LZHAM_MEM_STATS 0
@@ -72,9 +76,30 @@ namespace lzham
       return p ? malloc_usable_size(p) : 0;
    }
 
-   static lzham_realloc_func        g_pRealloc = lzham_default_realloc;
-   static lzham_msize_func          g_pMSize   = lzham_default_msize;
-   static void*                     g_pUser_data;
+   static lzham_allocator           g_allocator = { lzham_default_realloc, lzham_default_msize, NULL };
+
+   // The allocator of the context this thread is working on (see memory_scope), or NULL for g_allocator.
+   static thread_local const lzham_allocator* t_pAllocator;
+
+   // Allocations by this thread, for the compressor/decompressor statistics.
+   static thread_local lzham_alloc_stats t_alloc_stats;
+
+   static void* LZHAM_CDECL arena_realloc(void* p, size_t size, size_t* pActual_size, lzham_bool movable, void* pUser_data);
+
+   static inline void count_alloc(const lzham_allocator& allocator, size_t size)
+   {
+      t_alloc_stats.m_bytes += size;
+      t_alloc_stats.m_allocs++;
+
+      // Arenas count their own chunks.
+      if (allocator.m_pRealloc != arena_realloc)
+         t_alloc_stats.m_underlying_allocs++;
+   }
+
+   static inline const lzham_allocator& get_current_allocator()
+   {
+      return t_pAllocator ? *t_pAllocator : g_allocator;
+   }
 
    static inline void lzham_mem_error(const char* p_msg)
    {
@@ -93,8 +118,11 @@ namespace lzham
          return NULL;
       }
 
+      const lzham_allocator& allocator = get_current_allocator();
+      count_alloc(allocator, size);
+
       size_t actual_size = size;
-      uint8* p_new = static_cast<uint8*>((*g_pRealloc)(NULL, size, &actual_size, true, g_pUser_data));
+      uint8* p_new = static_cast<uint8*>((*allocator.m_pRealloc)(NULL, size, &actual_size, true, allocator.m_pUser_data));
 
       if (pActual_size)
          *pActual_size = actual_size;
@@ -124,8 +152,12 @@ namespace lzham
          return NULL;
       }
 
+      const lzham_allocator& allocator = get_current_allocator();
+      if (size)
+         count_alloc(allocator, size);
+
       size_t actual_size = size;
-      void* p_new = (*g_pRealloc)(p, size, &actual_size, movable, g_pUser_data);
+      void* p_new = (*allocator.m_pRealloc)(p, size, &actual_size, movable, allocator.m_pUser_data);
 
       if (pActual_size)
          *pActual_size = actual_size;
@@ -146,7 +178,8 @@ namespace lzham
          return;
       }
 
-      (*g_pRealloc)(p, 0, NULL, true, g_pUser_data);
+      const lzham_allocator& allocator = get_current_allocator();
+      (*allocator.m_pRealloc)(p, 0, NULL, true, allocator.m_pUser_data);
    }
 
    size_t lzham_msize(void* p)
@@ -160,23 +193,294 @@ namespace lzham
          return 0;
       }
 
-      return (*g_pMSize)(p, g_pUser_data);
+      const lzham_allocator& allocator = get_current_allocator();
+      return (*allocator.m_pMSize)(p, allocator.m_pUser_data);
+   }
+
+   const lzham_alloc_stats& lzham_get_alloc_stats()
+   {
+      return t_alloc_stats;
    }
 
    void LZHAM_CDECL lzham_lib_set_memory_callbacks(lzham_realloc_func pRealloc, lzham_msize_func pMSize, void* pUser_data)
    {
       if ((!pRealloc) || (!pMSize))
       {
-         g_pRealloc = lzham_default_realloc;
-         g_pMSize = lzham_default_msize;
-         g_pUser_data = NULL;
+         g_allocator.m_pRealloc = lzham_default_realloc;
+         g_allocator.m_pMSize = lzham_default_msize;
+         g_allocator.m_pUser_data = NULL;
       }
       else
       {
-         g_pRealloc = pRealloc;
-         g_pMSize = pMSize;
-         g_pUser_data = pUser_data;
+         g_allocator.m_pRealloc = pRealloc;
+         g_allocator.m_pMSize = pMSize;
+         g_allocator.m_pUser_data = pUser_data;
+      }
+   }
+
+   memory_scope::memory_scope(const lzham_allocator* pAllocator) :
+      m_pPrev_allocator(t_pAllocator)
+   {
+      t_pAllocator = pAllocator;
+   }
+
+   memory_scope::~memory_scope()
+   {
+      t_pAllocator = m_pPrev_allocator;
+   }
+
+   const lzham_allocator* lzham_get_allocator()
+   {
+      return t_pAllocator;
+   }
+
+   // Shared chunks are cArenaChunkSize bytes, including the header. Allocations larger than cArenaMaxSharedAllocSize get a chunk of
+   // their own, so the large buffers (e.g. the match finder's) can be freed or reallocated without wasting the space.
+   const size_t cArenaChunkSize = 256 * 1024;
+   const size_t cArenaMaxSharedAllocSize = cArenaChunkSize / 4;
+
+   struct arena
+   {
+      // Chunks are in a doubly linked list, so chunks holding a single allocation can be freed immediately.
+      struct chunk_header
+      {
+         chunk_header* m_pPrev;
+         chunk_header* m_pNext;
+      };
+
+      struct block_header
+      {
+         size_t m_size;
+         size_t m_own_chunk;
+      };
+
+      lzham_allocator m_parent;
+      chunk_header* m_pChunks;
+
+      // Free space in the current shared chunk, and the most recent allocation from it (unless it was freed), which ends at m_pCur.
+      uint8* m_pCur;
+      uint8* m_pEnd;
+      uint8* m_pLast;
+
+#if LZHAM_THREADING
+      // Helper threads allocate from their compressor's arena too.
+      pthread_mutex_t m_mutex;
+#endif
+   };
+
+   LZHAM_ASSUME(sizeof(arena::chunk_header) == LZHAM_MIN_ALLOC_ALIGNMENT);
+   LZHAM_ASSUME(sizeof(arena::block_header) == LZHAM_MIN_ALLOC_ALIGNMENT);
+
+   static arena::chunk_header* arena_new_chunk(arena* pArena, size_t size)
+   {
+      size_t actual_size = size;
+      arena::chunk_header* pChunk = static_cast<arena::chunk_header*>((*pArena->m_parent.m_pRealloc)(NULL, size, &actual_size, true, pArena->m_parent.m_pUser_data));
+      if (!pChunk)
+         return NULL;
+
+      t_alloc_stats.m_underlying_allocs++;
+
+      pChunk->m_pPrev = NULL;
+      pChunk->m_pNext = pArena->m_pChunks;
+      if (pArena->m_pChunks)
+         pArena->m_pChunks->m_pPrev = pChunk;
+      pArena->m_pChunks = pChunk;
+      return pChunk;
+   }
+
+   static void arena_free_chunk(arena* pArena, arena::chunk_header* pChunk)
+   {
+      if (pChunk->m_pPrev)
+         pChunk->m_pPrev->m_pNext = pChunk->m_pNext;
+      else
+         pArena->m_pChunks = pChunk->m_pNext;
+      if (pChunk->m_pNext)
+         pChunk->m_pNext->m_pPrev = pChunk->m_pPrev;
+
+      (*pArena->m_parent.m_pRealloc)(pChunk, 0, NULL, true, pArena->m_parent.m_pUser_data);
+   }
+
+   static void* arena_alloc(arena* pArena, size_t size)
+   {
+      size = (size + LZHAM_MIN_ALLOC_ALIGNMENT - 1) & ~(LZHAM_MIN_ALLOC_ALIGNMENT - 1);
+      const size_t block_size = sizeof(arena::block_header) + size;
+
+      arena::block_header* pBlock;
+      if (size > cArenaMaxSharedAllocSize)
+      {
+         arena::chunk_header* pChunk = arena_new_chunk(pArena, sizeof(arena::chunk_header) + block_size);
+         if (!pChunk)
+            return NULL;
+
+         pBlock = reinterpret_cast<arena::block_header*>(pChunk + 1);
+         pBlock->m_size = size;
+         pBlock->m_own_chunk = true;
+         return pBlock + 1;
+      }
+
+      if (static_cast<size_t>(pArena->m_pEnd - pArena->m_pCur) < block_size)
+      {
+         // The rest of the current chunk is wasted.
+         arena::chunk_header* pChunk = arena_new_chunk(pArena, cArenaChunkSize);
+         if (!pChunk)
+            return NULL;
+
+         pArena->m_pCur = reinterpret_cast<uint8*>(pChunk + 1);
+         pArena->m_pEnd = reinterpret_cast<uint8*>(pChunk) + cArenaChunkSize;
+      }
+
+      pBlock = reinterpret_cast<arena::block_header*>(pArena->m_pCur);
+      pBlock->m_size = size;
+      pBlock->m_own_chunk = false;
+
+      pArena->m_pCur += block_size;
+      pArena->m_pLast = reinterpret_cast<uint8*>(pBlock + 1);
+      return pArena->m_pLast;
+   }
+
+   static void arena_free(arena* pArena, void* p)
+   {
+      arena::block_header* pBlock = static_cast<arena::block_header*>(p) - 1;
+      if (pBlock->m_own_chunk)
+      {
+         arena_free_chunk(pArena, reinterpret_cast<arena::chunk_header*>(pBlock) - 1);
       }
+      else if (p == pArena->m_pLast)
+      {
+         pArena->m_pCur = reinterpret_cast<uint8*>(pBlock);
+         pArena->m_pLast = NULL;
+      }
+   }
+
+   static void* LZHAM_CDECL arena_realloc(void* p, size_t size, size_t* pActual_size, lzham_bool movable, void* pUser_data)
+   {
+      arena* pArena = static_cast<arena*>(pUser_data);
+
+#if LZHAM_THREADING
+      pthread_mutex_lock(&pArena->m_mutex);
+#endif
+
+      void* p_new = NULL;
+      size_t actual_size = 0;
+
+      if (!p)
+      {
+         p_new = arena_alloc(pArena, size);
+         if (p_new)
+            actual_size = (static_cast<arena::block_header*>(p_new) - 1)->m_size;
+      }
+      else if (!size)
+      {
+         arena_free(pArena, p);
+      }
+      else
+      {
+         arena::block_header* pBlock = static_cast<arena::block_header*>(p) - 1;
+         const size_t old_size = pBlock->m_size;
+         const size_t new_size = (size + LZHAM_MIN_ALLOC_ALIGNMENT - 1) & ~(LZHAM_MIN_ALLOC_ALIGNMENT - 1);
+
+         actual_size = old_size;
+
+         if (new_size <= old_size)
+         {
+            p_new = p;
+         }
+         else if ((p == pArena->m_pLast) && (static_cast<size_t>(pArena->m_pEnd - static_cast<uint8*>(p)) >= new_size))
+         {
+            // Grow the most recent allocation in place.
+            pBlock->m_size = new_size;
+            pArena->m_pCur = static_cast<uint8*>(p) + new_size;
+            p_new = p;
+            actual_size = new_size;
+         }
+         else if (movable)
+         {
+            p_new = arena_alloc(pArena, new_size);
+            if (p_new)
+            {
+               memcpy(p_new, p, old_size);
+               arena_free(pArena, p);
+               actual_size = (static_cast<arena::block_header*>(p_new) - 1)->m_size;
+            }
+         }
+      }
+
+#if LZHAM_THREADING
+      pthread_mutex_unlock(&pArena->m_mutex);
+#endif
+
+      if (pActual_size)
+         *pActual_size = actual_size;
+
+      return p_new;
+   }
+
+   static size_t LZHAM_CDECL arena_msize(void* p, void* pUser_data)
+   {
+      LZHAM_NOTE_UNUSED(pUser_data);
+      return p ? (static_cast<arena::block_header*>(p) - 1)->m_size : 0;
+   }
+
+   bool context_allocator::init(lzham_realloc_func pRealloc, lzham_msize_func pMSize, void* pUser_data, bool use_arena)
+   {
+      m_pArena = NULL;
+
+      if (pRealloc)
+      {
+         if (!pMSize)
+            return false;
+
+         m_allocator.m_pRealloc = pRealloc;
+         m_allocator.m_pMSize = pMSize;
+         m_allocator.m_pUser_data = pUser_data;
+      }
+      else
+      {
+         m_allocator = g_allocator;
+      }
+
+      if (use_arena)
+      {
+         size_t actual_size = sizeof(arena);
+         m_pArena = static_cast<arena*>((*m_allocator.m_pRealloc)(NULL, sizeof(arena), &actual_size, true, m_allocator.m_pUser_data));
+         if (!m_pArena)
+            return false;
+
+         m_pArena->m_parent = m_allocator;
+         m_pArena->m_pChunks = NULL;
+         m_pArena->m_pCur = NULL;
+         m_pArena->m_pEnd = NULL;
+         m_pArena->m_pLast = NULL;
+#if LZHAM_THREADING
+         pthread_mutex_init(&m_pArena->m_mutex, NULL);
+#endif
+
+         m_allocator.m_pRealloc = arena_realloc;
+         m_allocator.m_pMSize = arena_msize;
+         m_allocator.m_pUser_data = m_pArena;
+      }
+
+      return true;
+   }
+
+   void context_allocator::deinit()
+   {
+      if (!m_pArena)
+         return;
+
+      const lzham_allocator parent(m_pArena->m_parent);
+
+      while (m_pArena->m_pChunks)
+         arena_free_chunk(m_pArena, m_pArena->m_pChunks);
+
+#if LZHAM_THREADING
+      pthread_mutex_destroy(&m_pArena->m_mutex);
+#endif
+
+      (*parent.m_pRealloc)(m_pArena, 0, NULL, true, parent.m_pUser_data);
+      m_pArena = NULL;
+
+      m_allocator = parent;
    }
 
 } // namespace lzham
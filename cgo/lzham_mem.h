@@ -11,6 +11,60 @@ namespace lzham
    void     lzham_free(void* p);
    size_t   lzham_msize(void* p);
 
+   struct lzham_alloc_stats
+   {
+      uint64 m_bytes;               // bytes requested by lzham_malloc() and lzham_realloc()
+      uint64 m_allocs;              // calls to them which allocated or resized a block
+      uint64 m_underlying_allocs;   // blocks allocated or resized by the underlying allocator (for an arena, its chunks)
+   };
+
+   // Returns the running totals for the calling thread.
+   const lzham_alloc_stats& lzham_get_alloc_stats();
+
+   // Memory allocation callbacks (see lzham_set_memory_callbacks()).
+   struct lzham_allocator
+   {
+      lzham_realloc_func m_pRealloc;
+      lzham_msize_func m_pMSize;
+      void* m_pUser_data;
+   };
+
+   // Makes the calling thread's allocations use pAllocator (or the global allocator if it's NULL) until the scope ends. Each compression
+   // and decompression function uses one for the context's allocator, and helper threads use the allocator of the thread which queued
+   // the task. pAllocator must stay valid until then.
+   class memory_scope
+   {
+      LZHAM_NO_COPY_OR_ASSIGNMENT_OP(memory_scope);
+
+   public:
+      explicit memory_scope(const lzham_allocator* pAllocator);
+      ~memory_scope();
+
+   private:
+      const lzham_allocator* m_pPrev_allocator;
+   };
+
+   // Returns the calling thread's allocator, or NULL if it's using the global one.
+   const lzham_allocator* lzham_get_allocator();
+
+   struct arena;
+
+   // The allocator of a compressor or decompressor: the one from its parameters (or the global allocator), optionally wrapped in a bump
+   // arena owned by the context. An arena takes large chunks from the underlying allocator, only reclaims memory if the most recent
+   // allocation is freed (larger allocations get their own chunks, which are freed immediately), and releases everything at once when
+   // the context is deinitialized.
+   struct context_allocator
+   {
+      lzham_allocator m_allocator;
+      arena* m_pArena;
+
+      // Returns false if pRealloc is set without pMSize, or the arena can't be allocated.
+      bool init(lzham_realloc_func pRealloc, lzham_msize_func pMSize, void* pUser_data, bool use_arena);
+
+      // Frees the arena, if any. Everything allocated with m_allocator must have been freed (or be abandoned) first.
+      void deinit();
+   };
+
    template<typename T>
    inline T* lzham_new()
    {
@@ -20,6 +20,8 @@ LZHAM_FORCE_INLINE void lzham_yield_processor()
 }
 #endif
 
+#include <time.h>
+
 #ifdef __APPLE__
 #include <malloc/malloc.h>
 #define malloc_usable_size malloc_size
@@ -51,6 +53,61 @@ LZHAM_FORCE_INLINE void lzham_yield_processor()
 
 namespace lzham
 {
+#if LZHAM_THREADING
+   typedef long atomic32_t;
+   typedef long long atomic64_t;
+
+   inline atomic32_t atomic_compare_exchange32(atomic32_t volatile *pDest, atomic32_t exchange, atomic32_t comparand)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pDest) & 3) == 0);
+      __atomic_compare_exchange_n(pDest, &comparand, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+      return comparand;
+   }
+
+   inline atomic64_t atomic_compare_exchange64(atomic64_t volatile *pDest, atomic64_t exchange, atomic64_t comparand)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pDest) & 7) == 0);
+      __atomic_compare_exchange_n(pDest, &comparand, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+      return comparand;
+   }
+
+   inline atomic32_t atomic_increment32(atomic32_t volatile *pDest)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pDest) & 3) == 0);
+      return __atomic_add_fetch(pDest, 1, __ATOMIC_SEQ_CST);
+   }
+
+   inline atomic32_t atomic_decrement32(atomic32_t volatile *pDest)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pDest) & 3) == 0);
+      return __atomic_sub_fetch(pDest, 1, __ATOMIC_SEQ_CST);
+   }
+
+   inline atomic32_t atomic_exchange32(atomic32_t volatile *pDest, atomic32_t val)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pDest) & 3) == 0);
+      return __atomic_exchange_n(pDest, val, __ATOMIC_SEQ_CST);
+   }
+
+   inline atomic32_t atomic_add32(atomic32_t volatile *pDest, atomic32_t val)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pDest) & 3) == 0);
+      return __atomic_add_fetch(pDest, val, __ATOMIC_SEQ_CST);
+   }
+
+   inline atomic32_t atomic_exchange_add(atomic32_t volatile *pDest, atomic32_t val)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pDest) & 3) == 0);
+      return __atomic_fetch_add(pDest, val, __ATOMIC_SEQ_CST);
+   }
+
+   // Reads a value written by another thread with one of the above, including anything written before it.
+   inline atomic32_t atomic_load32(const atomic32_t volatile *pSrc)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pSrc) & 3) == 0);
+      return __atomic_load_n(pSrc, __ATOMIC_ACQUIRE);
+   }
+#else
    #define LZHAM_NO_ATOMICS 1
 
    // Atomic ops not supported - but try to do something reasonable. Assumes no threading at all.
@@ -109,4 +166,19 @@ namespace lzham
       return cur;
    }
 
+   inline atomic32_t atomic_load32(const atomic32_t volatile *pSrc)
+   {
+      LZHAM_ASSERT((reinterpret_cast<ptr_bits_t>(pSrc) & 3) == 0);
+      return *pSrc;
+   }
+#endif
+
+   // Returns a monotonic time in nanoseconds, for measuring intervals.
+   inline uint64 get_time_ns()
+   {
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return static_cast<uint64>(ts.tv_sec) * 1000000000U + static_cast<uint64>(ts.tv_nsec);
+   }
+
 } // namespace lzham
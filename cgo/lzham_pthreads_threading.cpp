@@ -0,0 +1,284 @@
+// File: lzham_pthreads_threading.cpp
+// See Copyright Notice and license at the end of lzham.h
+#include "lzham_core.h"
+
+#if LZHAM_THREADING
+
+#include "lzham_pthreads_threading.h"
+
+#include <time.h>
+#include <unistd.h>
+
+namespace lzham
+{
+   semaphore::semaphore(long initialCount, long maximumCount, const char* pName) :
+      m_count(initialCount),
+      m_max_count(maximumCount)
+   {
+      LZHAM_NOTE_UNUSED(pName);
+      pthread_mutex_init(&m_mutex, NULL);
+      pthread_cond_init(&m_cond, NULL);
+   }
+
+   semaphore::~semaphore()
+   {
+      pthread_cond_destroy(&m_cond);
+      pthread_mutex_destroy(&m_mutex);
+   }
+
+   void semaphore::release(long releaseCount, long *pPreviousCount)
+   {
+      pthread_mutex_lock(&m_mutex);
+      if (pPreviousCount)
+         *pPreviousCount = m_count;
+      m_count = LZHAM_MIN(m_count + releaseCount, m_max_count);
+      pthread_cond_broadcast(&m_cond);
+      pthread_mutex_unlock(&m_mutex);
+   }
+
+   bool semaphore::wait(uint32 milliseconds)
+   {
+      pthread_mutex_lock(&m_mutex);
+      if (milliseconds == UINT32_MAX)
+      {
+         while (!m_count)
+            pthread_cond_wait(&m_cond, &m_mutex);
+      }
+      else if (!m_count)
+      {
+         struct timespec deadline;
+         clock_gettime(CLOCK_REALTIME, &deadline);
+         deadline.tv_sec += milliseconds / 1000;
+         deadline.tv_nsec += (milliseconds % 1000) * 1000000L;
+         if (deadline.tv_nsec >= 1000000000L)
+         {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+         }
+         while (!m_count)
+         {
+            if (pthread_cond_timedwait(&m_cond, &m_mutex, &deadline))
+               break;
+         }
+      }
+      bool success = m_count != 0;
+      if (success)
+         m_count--;
+      pthread_mutex_unlock(&m_mutex);
+      return success;
+   }
+
+   task_pool::task_pool() :
+      m_num_threads(0),
+      m_task_head(0),
+      m_num_outstanding_tasks(0),
+      m_exit_flag(false)
+   {
+      pthread_mutex_init(&m_mutex, NULL);
+      pthread_cond_init(&m_tasks_available, NULL);
+      pthread_cond_init(&m_tasks_complete, NULL);
+   }
+
+   task_pool::task_pool(uint num_threads) :
+      m_num_threads(0),
+      m_task_head(0),
+      m_num_outstanding_tasks(0),
+      m_exit_flag(false)
+   {
+      pthread_mutex_init(&m_mutex, NULL);
+      pthread_cond_init(&m_tasks_available, NULL);
+      pthread_cond_init(&m_tasks_complete, NULL);
+
+      bool status = init(num_threads);
+      LZHAM_VERIFY(status);
+   }
+
+   task_pool::~task_pool()
+   {
+      deinit();
+      pthread_cond_destroy(&m_tasks_complete);
+      pthread_cond_destroy(&m_tasks_available);
+      pthread_mutex_destroy(&m_mutex);
+   }
+
+   bool task_pool::init(uint num_threads)
+   {
+      LZHAM_ASSERT(num_threads <= cMaxThreads);
+      num_threads = LZHAM_MIN(num_threads, static_cast<uint>(cMaxThreads));
+
+      deinit();
+
+      bool succeeded = true;
+
+      m_exit_flag = false;
+      while (m_num_threads < num_threads)
+      {
+         if (pthread_create(&m_threads[m_num_threads], NULL, thread_func, this))
+         {
+            succeeded = false;
+            break;
+         }
+         m_num_threads++;
+      }
+
+      if (!succeeded)
+      {
+         deinit();
+         return false;
+      }
+
+      return true;
+   }
+
+   void task_pool::deinit()
+   {
+      if (m_num_threads)
+      {
+         join();
+
+         pthread_mutex_lock(&m_mutex);
+         m_exit_flag = true;
+         pthread_cond_broadcast(&m_tasks_available);
+         pthread_mutex_unlock(&m_mutex);
+
+         for (uint i = 0; i < m_num_threads; i++)
+            pthread_join(m_threads[i], NULL);
+
+         m_num_threads = 0;
+         m_exit_flag = false;
+      }
+
+      m_tasks.clear();
+      m_task_head = 0;
+      m_num_outstanding_tasks = 0;
+   }
+
+   uint task_pool::get_num_outstanding_tasks() const
+   {
+      pthread_mutex_lock(&m_mutex);
+      uint num_outstanding_tasks = m_num_outstanding_tasks;
+      pthread_mutex_unlock(&m_mutex);
+      return num_outstanding_tasks;
+   }
+
+   bool task_pool::queue_task(task_callback_func pFunc, uint64 data, void* pData_ptr)
+   {
+      LZHAM_ASSERT(pFunc);
+
+      task tsk;
+      tsk.m_data = data;
+      tsk.m_pData_ptr = pData_ptr;
+      tsk.m_callback = pFunc;
+      tsk.m_pObj = NULL;
+      tsk.m_pAllocator = lzham_get_allocator();
+      return queue(tsk);
+   }
+
+   bool task_pool::queue_task(executable_task* pObj, uint64 data, void* pData_ptr)
+   {
+      LZHAM_ASSERT(pObj);
+
+      task tsk;
+      tsk.m_data = data;
+      tsk.m_pData_ptr = pData_ptr;
+      tsk.m_callback = NULL;
+      tsk.m_pObj = pObj;
+      tsk.m_pAllocator = lzham_get_allocator();
+      return queue(tsk);
+   }
+
+   bool task_pool::queue(const task& tsk)
+   {
+      // Without any threads, run the task immediately like the null task pool.
+      if (!m_num_threads)
+      {
+         task t(tsk);
+         process_task(t);
+         return true;
+      }
+
+      pthread_mutex_lock(&m_mutex);
+
+      // Reclaim the space used by completed tasks once the queue drains.
+      if (m_task_head == m_tasks.size())
+      {
+         m_tasks.try_resize(0);
+         m_task_head = 0;
+      }
+
+      bool succeeded = m_tasks.try_push_back(tsk);
+      if (succeeded)
+      {
+         m_num_outstanding_tasks++;
+         pthread_cond_signal(&m_tasks_available);
+      }
+
+      pthread_mutex_unlock(&m_mutex);
+
+      return succeeded;
+   }
+
+   void task_pool::process_task(task& tsk)
+   {
+      memory_scope scope(tsk.m_pAllocator);
+
+      if (tsk.m_pObj)
+         tsk.m_pObj->execute_task(tsk.m_data, tsk.m_pData_ptr);
+      else
+         tsk.m_callback(tsk.m_data, tsk.m_pData_ptr);
+   }
+
+   void task_pool::join()
+   {
+      pthread_mutex_lock(&m_mutex);
+      while (m_num_outstanding_tasks)
+         pthread_cond_wait(&m_tasks_complete, &m_mutex);
+      pthread_mutex_unlock(&m_mutex);
+   }
+
+   void* task_pool::thread_func(void *pContext)
+   {
+      task_pool* pPool = static_cast<task_pool*>(pContext);
+
+      pthread_mutex_lock(&pPool->m_mutex);
+      for ( ; ; )
+      {
+         while ((!pPool->m_exit_flag) && (pPool->m_task_head == pPool->m_tasks.size()))
+            pthread_cond_wait(&pPool->m_tasks_available, &pPool->m_mutex);
+
+         if (pPool->m_exit_flag)
+            break;
+
+         task tsk(pPool->m_tasks[pPool->m_task_head++]);
+
+         pthread_mutex_unlock(&pPool->m_mutex);
+         pPool->process_task(tsk);
+         pthread_mutex_lock(&pPool->m_mutex);
+
+         if (--pPool->m_num_outstanding_tasks == 0)
+            pthread_cond_broadcast(&pPool->m_tasks_complete);
+      }
+      pthread_mutex_unlock(&pPool->m_mutex);
+
+      return NULL;
+   }
+
+   void lzham_sleep(unsigned int milliseconds)
+   {
+      struct timespec interval;
+      interval.tv_sec = milliseconds / 1000;
+      interval.tv_nsec = (milliseconds % 1000) * 1000000L;
+      nanosleep(&interval, NULL);
+   }
+
+   uint lzham_get_max_helper_threads()
+   {
+      long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+      if (num_cpus <= 1)
+         return 0;
+      return static_cast<uint>(LZHAM_MIN(num_cpus - 1, static_cast<long>(LZHAM_MAX_HELPER_THREADS)));
+   }
+
+} // namespace lzham
+
+#endif // LZHAM_THREADING
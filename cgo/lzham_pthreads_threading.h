@@ -0,0 +1,144 @@
+// File: lzham_pthreads_threading.h
+// See Copyright Notice and license at the end of lzham.h
+#pragma once
+
+#if LZHAM_THREADING
+
+#include <pthread.h>
+
+namespace lzham
+{
+   class semaphore
+   {
+      LZHAM_NO_COPY_OR_ASSIGNMENT_OP(semaphore);
+
+   public:
+      semaphore(long initialCount = 0, long maximumCount = 1, const char* pName = NULL);
+      ~semaphore();
+
+      void release(long releaseCount = 1, long *pPreviousCount = NULL);
+      bool wait(uint32 milliseconds = UINT32_MAX);
+
+   private:
+      pthread_mutex_t m_mutex;
+      pthread_cond_t m_cond;
+      long m_count;
+      long m_max_count;
+   };
+
+   class task_pool
+   {
+      LZHAM_NO_COPY_OR_ASSIGNMENT_OP(task_pool);
+
+   public:
+      task_pool();
+      task_pool(uint num_threads);
+      ~task_pool();
+
+      enum { cMaxThreads = LZHAM_MAX_HELPER_THREADS };
+      bool init(uint num_threads);
+      void deinit();
+
+      inline uint get_num_threads() const { return m_num_threads; }
+      uint get_num_outstanding_tasks() const;
+
+      // C-style task callback
+      typedef void (*task_callback_func)(uint64 data, void* pData_ptr);
+      bool queue_task(task_callback_func pFunc, uint64 data = 0, void* pData_ptr = NULL);
+
+      class executable_task
+      {
+      public:
+         virtual ~executable_task() { }
+         virtual void execute_task(uint64 data, void* pData_ptr) = 0;
+      };
+
+      // It's the caller's responsibility to delete pObj within the execute_task() method, if needed!
+      bool queue_task(executable_task* pObj, uint64 data = 0, void* pData_ptr = NULL);
+
+      template<typename S, typename T>
+      inline bool queue_object_task(S* pObject, T pObject_method, uint64 data = 0, void* pData_ptr = NULL);
+
+      template<typename S, typename T>
+      inline bool queue_multiple_object_tasks(S* pObject, T pObject_method, uint64 first_data, uint num_tasks, void* pData_ptr = NULL);
+
+      // Waits for all queued tasks to complete.
+      void join();
+
+   private:
+      struct task
+      {
+         uint64 m_data;
+         void* m_pData_ptr;
+         task_callback_func m_callback;
+         executable_task* m_pObj;
+         const lzham_allocator* m_pAllocator; // of the thread which queued the task
+      };
+
+      template<typename S>
+      class object_task : public executable_task
+      {
+      public:
+         typedef void (S::*object_method_ptr)(uint64 data, void* pData_ptr);
+
+         object_task(S* pObject, object_method_ptr pMethod) : m_pObject(pObject), m_pMethod(pMethod) { }
+
+         virtual void execute_task(uint64 data, void* pData_ptr)
+         {
+            (m_pObject->*m_pMethod)(data, pData_ptr);
+            lzham_delete(this);
+         }
+
+      private:
+         S* m_pObject;
+         object_method_ptr m_pMethod;
+      };
+
+      bool queue(const task& tsk);
+      void process_task(task& tsk);
+      static void* thread_func(void *pContext);
+
+      pthread_t m_threads[cMaxThreads];
+      uint m_num_threads;
+
+      // Protects everything below.
+      mutable pthread_mutex_t m_mutex;
+      pthread_cond_t m_tasks_available;
+      pthread_cond_t m_tasks_complete;
+      lzham::vector<task> m_tasks; // FIFO, starting at m_task_head
+      uint m_task_head;
+      uint m_num_outstanding_tasks; // queued or executing
+      bool m_exit_flag;
+   };
+
+   template<typename S, typename T>
+   inline bool task_pool::queue_object_task(S* pObject, T pObject_method, uint64 data, void* pData_ptr)
+   {
+      object_task<S> *pTask = lzham_new< object_task<S> >(pObject, pObject_method);
+      if (!pTask)
+         return false;
+      if (!queue_task(pTask, data, pData_ptr))
+      {
+         lzham_delete(pTask);
+         return false;
+      }
+      return true;
+   }
+
+   template<typename S, typename T>
+   inline bool task_pool::queue_multiple_object_tasks(S* pObject, T pObject_method, uint64 first_data, uint num_tasks, void* pData_ptr)
+   {
+      for (uint i = 0; i < num_tasks; i++)
+      {
+         if (!queue_object_task(pObject, pObject_method, first_data + i, pData_ptr))
+            return false;
+      }
+      return true;
+   }
+
+   void lzham_sleep(unsigned int milliseconds);
+   uint lzham_get_max_helper_threads();
+
+} // namespace lzham
+
+#endif // LZHAM_THREADING
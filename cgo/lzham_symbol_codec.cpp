@@ -654,6 +654,7 @@ namespace lzham
       m_pDecode_buf_next = NULL;
       m_pDecode_buf_end = NULL;
       m_decode_buf_size = 0;
+      m_decode_padding_bytes = 0;
 
       m_bit_buf = 0;
       m_bit_count = 0;
@@ -668,7 +669,8 @@ namespace lzham
 
       m_output_buf.try_resize(0);
       m_arith_output_buf.try_resize(0);
-      m_output_syms.try_resize(0);
+      m_arith_output_bit_ofs.try_resize(0);
+      m_arith_bytes_to_place = 0;
 
       m_pDecode_need_bytes_func = NULL;
       m_pDecode_private_data = NULL;
@@ -683,7 +685,7 @@ namespace lzham
 
       m_output_buf.clear();
       m_arith_output_buf.clear();
-      m_output_syms.clear();
+      m_arith_output_bit_ofs.clear();
    }
 
    bool symbol_codec::start_encoding(uint expected_file_size)
@@ -696,8 +698,6 @@ namespace lzham
       if (!put_bits_init(expected_file_size))
          return false;
 
-      m_output_syms.try_resize(0);
-
       arith_start_encoding();
 
       return true;
@@ -714,14 +714,14 @@ namespace lzham
 
       if (num_bits > 16)
       {
-         if (!record_put_bits(bits >> 16, num_bits - 16))
+         if (!put_bits(bits >> 16, num_bits - 16))
             return false;
-         if (!record_put_bits(bits & 0xFFFF, 16))
+         if (!put_bits(bits & 0xFFFF, 16))
             return false;
       }
       else
       {
-         if (!record_put_bits(bits, num_bits))
+         if (!put_bits(bits, num_bits))
             return false;
       }
       return true;
@@ -730,29 +730,17 @@ namespace lzham
    bool symbol_codec::encode_arith_init()
    {
       LZHAM_ASSERT(m_mode == cEncoding);
+      LZHAM_ASSERT(!m_arith_output_buf.size() && !m_arith_output_bit_ofs.size());
 
-      output_symbol sym;
-      sym.m_bits = 0;
-      sym.m_num_bits = output_symbol::cArithInit;
-      sym.m_arith_prob0 = 0;
-      if (!m_output_syms.try_push_back(sym))
-         return false;
-
-      return true;
+      // The decoder reads the first 4 bytes when it starts arithmetic decoding.
+      return arith_place_bytes(4);
    }
 
    bool symbol_codec::encode_align_to_byte()
    {
       LZHAM_ASSERT(m_mode == cEncoding);
 
-      output_symbol sym;
-      sym.m_bits = 0;
-      sym.m_num_bits = output_symbol::cAlignToByteSym;
-      sym.m_arith_prob0 = 0;
-      if (!m_output_syms.try_push_back(sym))
-         return false;
-
-      return true;
+      return put_bits_align_to_byte();
    }
 
    bool symbol_codec::encode(uint sym, quasi_adaptive_huffman_data_model& model)
@@ -760,7 +748,7 @@ namespace lzham
       LZHAM_ASSERT(m_mode == cEncoding);
       LZHAM_ASSERT(model.m_encoding);
 
-      if (!record_put_bits(model.m_codes[sym], model.m_code_sizes[sym]))
+      if (!put_bits(model.m_codes[sym], model.m_code_sizes[sym]))
          return false;
 
       uint freq = model.m_sym_freq[sym];
@@ -803,7 +791,7 @@ namespace lzham
       {
          if (!m_arith_output_buf.try_push_back((m_arith_base >> 24) & 0xFF))
             return false;
-         m_total_bits_written += 8;
+         m_arith_bytes_to_place++;
 
          m_arith_base <<= 8;
       } while ((m_arith_length <<= 8) < cSymbolCodecArithMinLen);
@@ -813,6 +801,8 @@ namespace lzham
    void symbol_codec::arith_start_encoding()
    {
       m_arith_output_buf.try_resize(0);
+      m_arith_output_bit_ofs.try_resize(0);
+      m_arith_bytes_to_place = 0;
 
       m_arith_base = 0;
       m_arith_value = 0;
@@ -826,12 +816,13 @@ namespace lzham
 
       m_arith_total_bits++;
 
-      output_symbol sym;
-      sym.m_bits = bit;
-      sym.m_num_bits = -1;
-      sym.m_arith_prob0 = model.m_bit_0_prob;
-      if (!m_output_syms.try_push_back(sym))
-         return false;
+      // This must match the decoder, which renormalizes right before decoding each bit.
+      if (m_arith_bytes_to_place)
+      {
+         if (!arith_place_bytes(m_arith_bytes_to_place))
+            return false;
+         m_arith_bytes_to_place = 0;
+      }
 
       uint x = model.m_bit_0_prob * (m_arith_length >> cSymbolCodecArithProbBits);
 
@@ -907,47 +898,60 @@ namespace lzham
       {
          if (!m_arith_output_buf.try_push_back(0))
             return false;
-         m_total_bits_written += 8;
       }
       return true;
    }
 
-   bool symbol_codec::stop_encoding(bool support_arith)
+   bool symbol_codec::arith_place_bytes(uint num_bytes)
    {
-      LZHAM_ASSERT(m_mode == cEncoding);
-
-      if (support_arith)
+      for (uint i = 0; i < num_bytes; i++)
       {
-         if (!arith_stop_encoding())
+         uint bit_ofs = (m_output_buf.size() << 3) + (cBitBufSize - m_bit_count);
+         if (!m_arith_output_bit_ofs.try_push_back(bit_ofs))
+            return false;
+         if (!put_bits(0, 8))
             return false;
       }
+      return true;
+   }
 
-      if (!assemble_output_buf())
-         return false;
+   void symbol_codec::arith_fill_placed_bytes()
+   {
+      // Bytes the decoder reads past the end of the arithmetic coded data are zero, which is what was placed already.
+      const uint num_bytes = LZHAM_MIN(m_arith_output_buf.size(), m_arith_output_bit_ofs.size());
 
-      m_mode = cNull;
-      return true;
+      for (uint i = 0; i < num_bytes; i++)
+      {
+         const uint c = m_arith_output_buf[i];
+         const uint bit_ofs = m_arith_output_bit_ofs[i];
+         const uint shift = bit_ofs & 7;
+
+         uint8* pDst = &m_output_buf[bit_ofs >> 3];
+         pDst[0] |= static_cast<uint8>(c >> shift);
+         if (shift)
+            pDst[1] |= static_cast<uint8>(c << (8 - shift));
+      }
    }
 
-   bool symbol_codec::record_put_bits(uint bits, uint num_bits)
+   bool symbol_codec::stop_encoding(bool support_arith)
    {
       LZHAM_ASSERT(m_mode == cEncoding);
 
-      LZHAM_ASSERT(num_bits <= 25);
-      LZHAM_ASSERT(m_bit_count >= 25);
-
-      if (!num_bits)
-         return true;
+      // Without the final arithmetic coded bytes, nothing can be filled in where the decoder reads them.
+      LZHAM_ASSERT(support_arith || !m_arith_output_bit_ofs.size());
 
-      m_total_bits_written += num_bits;
+      if (support_arith)
+      {
+         if (!arith_stop_encoding())
+            return false;
+      }
 
-      output_symbol sym;
-      sym.m_bits = bits;
-      sym.m_num_bits = (uint16)num_bits;
-      sym.m_arith_prob0 = 0;
-      if (!m_output_syms.try_push_back(sym))
+      if (!flush_bits())
          return false;
 
+      arith_fill_placed_bytes();
+
+      m_mode = cNull;
       return true;
    }
 
@@ -1004,80 +1008,6 @@ namespace lzham
       return put_bits(0, 7); // to ensure the last bits are flushed
    }
 
-   bool symbol_codec::assemble_output_buf()
-   {
-      m_total_bits_written = 0;
-
-      uint arith_buf_ofs = 0;
-
-      // Intermix the final Arithmetic, Huffman, or plain bits to a single combined bitstream.
-      // All bits from each source must be output in exactly the same order that the decompressor will read them.
-      for (uint sym_index = 0; sym_index < m_output_syms.size(); sym_index++)
-      {
-         const output_symbol& sym = m_output_syms[sym_index];
-
-         if (sym.m_num_bits == output_symbol::cAlignToByteSym)
-         {
-            if (!put_bits_align_to_byte())
-               return false;
-         }
-         else if (sym.m_num_bits == output_symbol::cArithInit)
-         {
-            LZHAM_ASSERT(m_arith_output_buf.size());
-
-            if (m_arith_output_buf.size())
-            {
-               m_arith_length = cSymbolCodecArithMaxLen;
-               m_arith_value = 0;
-               for (uint i = 0; i < 4; i++)
-               {
-                  const uint c = m_arith_output_buf[arith_buf_ofs++];
-                  m_arith_value = (m_arith_value << 8) | c;
-                  if (!put_bits(c, 8))
-                     return false;
-               }
-            }
-         }
-         else if (sym.m_num_bits == output_symbol::cArithSym)
-         {
-            // This renorm logic must match the logic used in the arithmetic decoder.
-            if (m_arith_length < cSymbolCodecArithMinLen)
-            {
-               do
-               {
-                  const uint c = (arith_buf_ofs < m_arith_output_buf.size()) ? m_arith_output_buf[arith_buf_ofs++] : 0;
-                  if (!put_bits(c, 8))
-                     return false;
-                  m_arith_value = (m_arith_value << 8) | c;
-               } while ((m_arith_length <<= 8) < cSymbolCodecArithMinLen);
-            }
-
-            uint x = sym.m_arith_prob0 * (m_arith_length >> cSymbolCodecArithProbBits);
-            uint bit = (m_arith_value >= x);
-
-            if (bit == 0)
-            {
-               m_arith_length = x;
-            }
-            else
-            {
-               m_arith_value  -= x;
-               m_arith_length -= x;
-            }
-
-            LZHAM_VERIFY(bit == sym.m_bits);
-         }
-         else
-         {
-            // Huffman or plain bits
-            if (!put_bits(sym.m_bits, sym.m_num_bits))
-               return false;
-         }
-      }
-
-      return flush_bits();
-   }
-
    //------------------------------------------------------------------------------------------------------------------
    // Decoding
    //------------------------------------------------------------------------------------------------------------------
@@ -1097,6 +1027,7 @@ namespace lzham
       m_pDecode_need_bytes_func = pNeed_bytes_func;
       m_pDecode_private_data = pPrivate_data;
       m_decode_buf_eof = eof_flag;
+      m_decode_padding_bytes = 0;
 
       m_bit_buf = 0;
       m_bit_count = 0;
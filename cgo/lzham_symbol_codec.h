@@ -216,6 +216,7 @@ namespace lzham
       const uint8*            m_pDecode_buf_end;
       size_t                  m_decode_buf_size;
       bool                    m_decode_buf_eof;
+      uint                    m_decode_padding_bytes; // zero bytes supplied by the decode macros past the end of the input
 
       need_bytes_func_ptr     m_pDecode_need_bytes_func;
       void*                   m_pDecode_private_data;
@@ -234,23 +235,13 @@ namespace lzham
       uint                    m_total_model_updates;
 
       lzham::vector<uint8>    m_output_buf;
-      lzham::vector<uint8>    m_arith_output_buf;
-
-      struct output_symbol
-      {
-         uint m_bits;
-
-         enum
-         {
-            cArithSym = -1,
-            cAlignToByteSym = -2,
-            cArithInit = -3
-         };
-         int16 m_num_bits;
 
-         uint16 m_arith_prob0;
-      };
-      lzham::vector<output_symbol> m_output_syms;
+      // Huffman and plain bits are written to m_output_buf as they're encoded. Arithmetic coded bytes can still change
+      // (due to carries) after they're output, and the decoder reads them lazily in between the other bits, so instead
+      // 8 zero bits are written where the decoder will read each one, and they're filled in by stop_encoding().
+      lzham::vector<uint8>    m_arith_output_buf;
+      lzham::vector<uint>     m_arith_output_bit_ofs; // where each byte of m_arith_output_buf goes in m_output_buf
+      uint                    m_arith_bytes_to_place; // bytes output by the last renormalization, which the decoder reads before the next bit
 
       uint                    m_total_bits_written;
 
@@ -264,17 +255,17 @@ namespace lzham
       uint                    m_saved_node_index;
 
       bool put_bits_init(uint expected_size);
-      bool record_put_bits(uint bits, uint num_bits);
 
       void arith_propagate_carry();
       bool arith_renorm_enc_interval();
       void arith_start_encoding();
       bool arith_stop_encoding();
+      bool arith_place_bytes(uint num_bytes);
+      void arith_fill_placed_bytes();
 
       bool put_bits(uint bits, uint num_bits);
       bool put_bits_align_to_byte();
       bool flush_bits();
-      bool assemble_output_buf();
 
       uint get_bits(uint num_bits);
       void remove_bits(uint num_bits);
@@ -331,7 +322,7 @@ namespace lzham
             LZHAM_SYMBOL_CODEC_DECODE_BEGIN(codec) \
          } \
          r = 0; \
-         if (LZHAM_BUILTIN_EXPECT(pDecode_buf_next < codec.m_pDecode_buf_end, 1)) r = *pDecode_buf_next++; \
+         if (LZHAM_BUILTIN_EXPECT(pDecode_buf_next < codec.m_pDecode_buf_end, 1)) r = *pDecode_buf_next++; else codec.m_decode_padding_bytes++; \
       } \
       else \
          r = *pDecode_buf_next++; \
@@ -405,6 +396,11 @@ namespace lzham
    result = node_index - pArith_data_model->m_total_syms; \
 }
 
+// Rebuilds a model's decoding tables once enough symbols have been decoded. Decoders may redefine this (e.g. to collect statistics).
+#ifndef LZHAM_SYMBOL_CODEC_DECODE_UPDATE_MODEL
+#define LZHAM_SYMBOL_CODEC_DECODE_UPDATE_MODEL(pModel) pModel->update()
+#endif
+
 #if LZHAM_SYMBOL_CODEC_USE_64_BIT_BUFFER
 #define LZHAM_SYMBOL_CODEC_DECODE_ADAPTIVE_HUFFMAN(codec, result, model) \
 { \
@@ -427,7 +423,7 @@ namespace lzham
                LZHAM_SYMBOL_CODEC_DECODE_BEGIN(codec) \
                pModel = codec.m_pSaved_huff_model; pTables = pModel->m_pDecode_tables; \
             } \
-            c = 0; if (pDecode_buf_next < codec.m_pDecode_buf_end) c = *pDecode_buf_next++; \
+            c = 0; if (pDecode_buf_next < codec.m_pDecode_buf_end) c = *pDecode_buf_next++; else codec.m_decode_padding_bytes++; \
             bit_count += 8; \
             bit_buf |= (static_cast<symbol_codec::bit_buf_t>(c) << (symbol_codec::cBitBufSize - bit_count)); \
          } \
@@ -468,7 +464,7 @@ namespace lzham
    LZHAM_ASSERT(freq <= UINT16_MAX); \
    if (LZHAM_BUILTIN_EXPECT(--pModel->m_symbols_until_update == 0, 0)) \
    { \
-      pModel->update(); \
+      LZHAM_SYMBOL_CODEC_DECODE_UPDATE_MODEL(pModel); \
    } \
 }
 #else
@@ -489,7 +485,7 @@ namespace lzham
             LZHAM_SYMBOL_CODEC_DECODE_BEGIN(codec) \
             pModel = codec.m_pSaved_huff_model; pTables = pModel->m_pDecode_tables; \
          } \
-         c = 0; if (LZHAM_BUILTIN_EXPECT(pDecode_buf_next < codec.m_pDecode_buf_end, 1)) c = *pDecode_buf_next++; \
+         c = 0; if (LZHAM_BUILTIN_EXPECT(pDecode_buf_next < codec.m_pDecode_buf_end, 1)) c = *pDecode_buf_next++; else codec.m_decode_padding_bytes++; \
       } \
       else \
          c = *pDecode_buf_next++; \
@@ -525,7 +521,7 @@ namespace lzham
    LZHAM_ASSERT(freq <= UINT16_MAX); \
    if (LZHAM_BUILTIN_EXPECT(--pModel->m_symbols_until_update == 0, 0)) \
    { \
-      pModel->update(); \
+      LZHAM_SYMBOL_CODEC_DECODE_UPDATE_MODEL(pModel); \
    } \
 }
 #endif
@@ -0,0 +1,59 @@
+package tf2lzham
+
+// #include "tf2lzham.h"
+import "C"
+
+import (
+	"errors"
+	"unsafe"
+
+	"github.com/pg9182/tf2lzham/internal/parallel"
+)
+
+// ParallelBlockSize is the block size used by the compressor for the TF2
+// dictionary size. CompressParallel rounds chunks up to a multiple of it.
+const ParallelBlockSize = parallel.BlockSize
+
+// CompressParallel is like Compress, but splits src into chunks of chunkSize
+// bytes (rounded up to a multiple of ParallelBlockSize), compresses them on up
+// to workers goroutines (GOMAXPROCS if zero), and splices them into a single
+// stream. Since each chunk starts with fresh models and can't reference earlier
+// chunks, the ratio is worse than Compress, but the output can still be
+// decompressed by Decompress (or the game). If src fits in a single chunk, it
+// is equivalent to Compress.
+func CompressParallel(dst, src []byte, chunkSize, workers int) (n int, adler32, crc32 uint32, err error) {
+	return parallel.Compress(dst, src, chunkSize, workers, Compress, func() (parallel.ChunkFunc, func(), error) {
+		c, _ := compressorPool.Get().(*Compressor)
+		if c == nil {
+			var err error
+			if c, err = NewCompressor(); err != nil {
+				return nil, nil, err
+			}
+		}
+		return c.compressChunk, func() { compressorPool.Put(c) }, nil
+	})
+}
+
+// compressChunk compresses a single chunk of a stream with the specified chunk
+// flags and the Adler-32 of the earlier chunks.
+func (c *Compressor) compressChunk(dst, src []byte, flags, seed uint32) (n int, adler32, crc32 uint32, err error) {
+	if c.c == nil {
+		return 0, 0, 0, errors.New("lzham: compressor closed")
+	}
+	if len(dst) == 0 || len(src) == 0 {
+		return 0, 0, 0, errors.New("lzham: zero-length buffer")
+	}
+	var (
+		_dst         *C.uint8_t  = (*C.uint8_t)(unsafe.Pointer(&dst[0]))
+		_src         *C.uint8_t  = (*C.uint8_t)(unsafe.Pointer(&src[0]))
+		_dst_len     *C.size_t   = &c.dst_len
+		_src_len     C.size_t    = C.size_t(len(src))
+		_adler32_out *C.uint32_t = &c.adler32_out
+		_crc32_out   *C.uint32_t = &c.crc32_out
+	)
+	*_dst_len = C.size_t(len(dst))
+	if _err := C.tf2lzham_compress_strerror(C.tf2lzham_compressor_compress_chunk(c.c, _dst, _dst_len, _src, _src_len, _adler32_out, _crc32_out, C.uint32_t(flags), C.uint32_t(seed))); _err != nil {
+		return 0, 0, 0, errors.New("lzham: " + C.GoString(_err))
+	}
+	return int(*_dst_len), uint32(*_adler32_out), uint32(*_crc32_out), nil
+}
@@ -0,0 +1,58 @@
+package tf2lzham
+
+import (
+	"bytes"
+	"hash/adler32"
+	"testing"
+)
+
+func TestCompressParallel(t *testing.T) {
+	src := append(testRecords(700<<10, 1), testRandom(200<<10, 2)...)
+	src = append(src, testRecords(400<<10+5, 3)...)
+
+	for _, x := range []struct{ chunkSize, workers int }{
+		{1, 0}, // rounded up to ParallelBlockSize
+		{ParallelBlockSize, 1},
+		{ParallelBlockSize, 3},
+		{512 << 10, 0},
+		{1 << 20, 2},
+	} {
+		dst := make([]byte, compressBound(len(src)))
+		n, adler, _, err := CompressParallel(dst, src, x.chunkSize, x.workers)
+		if err != nil {
+			t.Fatalf("chunk size %d, %d workers: compress: %v", x.chunkSize, x.workers, err)
+		}
+		if exp := adler32.Checksum(src); adler != exp {
+			t.Errorf("chunk size %d, %d workers: adler32 %08x, expected %08x", x.chunkSize, x.workers, adler, exp)
+		}
+		checkDecompress(t, dst[:n], src)
+	}
+
+	// same as Compress if src fits in a single chunk (after rounding up)
+	for _, n := range []int{64 << 10, ParallelBlockSize} {
+		dst, ref := make([]byte, compressBound(n)), make([]byte, compressBound(n))
+		m, _, _, err := CompressParallel(dst, src[:n], 1, 0)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if r, _, _, err := Compress(ref, src[:n]); err != nil {
+			t.Fatal(err)
+		} else if !bytes.Equal(dst[:m], ref[:r]) {
+			t.Errorf("%d bytes: output differs from Compress", n)
+		}
+	}
+
+	dst := make([]byte, compressBound(len(src)))
+	if _, _, _, err := CompressParallel(dst, src, 0, 0); err == nil {
+		t.Errorf("expected error for an invalid chunk size")
+	}
+	if _, _, _, err := CompressParallel(dst, src, ParallelBlockSize, -1); err == nil {
+		t.Errorf("expected error for an invalid worker count")
+	}
+	if _, _, _, err := CompressParallel(dst[:len(dst)/4], src, ParallelBlockSize, 0); err == nil {
+		t.Errorf("expected error for a small output buffer")
+	}
+	if _, _, _, err := CompressParallel(nil, src, ParallelBlockSize, 0); err == nil {
+		t.Errorf("expected error for a zero-length buffer")
+	}
+}
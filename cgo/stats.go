@@ -0,0 +1,102 @@
+package tf2lzham
+
+// #include "tf2lzham.h"
+import "C"
+
+import (
+	"errors"
+	"time"
+)
+
+// Stats contains statistics for the last call to Compress or Decompress on a
+// Compressor or Decompressor. The compression-only fields are zero for
+// decompression, and the symbol counts are only filled in for decompression by
+// a Decompressor created with NewDecompressorStats.
+type Stats struct {
+	Total       time.Duration
+	MatchFinder time.Duration // with helper threads, only adding the input and waiting for them
+	Parse       time.Duration // including cost evaluation (and everything else for LevelGreedy)
+	Coding      time.Duration // everything else (mostly coding the parsed symbols and checksums)
+
+	SrcBytes         uint64
+	DstBytes         uint64
+	CompressedBlocks uint64
+	RawBlocks        uint64 // blocks stored uncompressed since they didn't compress
+
+	Literals      uint64
+	DeltaLiterals uint64 // literals coded relative to the byte at the last match distance
+	RepMatches    [4]uint64
+	FullMatches   uint64 // including Len2Matches
+	Len2Matches   uint64
+	TableRebuilds uint64        // Huffman table updates
+	TableRebuild  time.Duration // decompression only, included in Total
+
+	BytesAllocated   uint64
+	Allocs           uint64 // blocks allocated or resized
+	UnderlyingAllocs uint64 // of those, the ones which reached the C allocator (with the arena, only its chunks)
+}
+
+func makeStats(s *C.tf2lzham_stats) Stats {
+	return Stats{
+		Total:            time.Duration(s.total_ns),
+		MatchFinder:      time.Duration(s.match_finder_ns),
+		Parse:            time.Duration(s.parse_ns),
+		Coding:           time.Duration(s.coding_ns),
+		SrcBytes:         uint64(s.src_bytes),
+		DstBytes:         uint64(s.dst_bytes),
+		CompressedBlocks: uint64(s.compressed_blocks),
+		RawBlocks:        uint64(s.raw_blocks),
+		Literals:         uint64(s.literals),
+		DeltaLiterals:    uint64(s.delta_literals),
+		RepMatches:       [4]uint64{uint64(s.rep_matches[0]), uint64(s.rep_matches[1]), uint64(s.rep_matches[2]), uint64(s.rep_matches[3])},
+		FullMatches:      uint64(s.full_matches),
+		Len2Matches:      uint64(s.len2_matches),
+		TableRebuilds:    uint64(s.table_rebuilds),
+		TableRebuild:     time.Duration(s.table_rebuild_ns),
+		BytesAllocated:   uint64(s.bytes_allocated),
+		Allocs:           uint64(s.allocs),
+		UnderlyingAllocs: uint64(s.underlying_allocs),
+	}
+}
+
+// Stats returns the statistics for the last call to Compress (or the last item
+// compressed by CompressBatch).
+func (c *Compressor) Stats() (Stats, error) {
+	if c.c == nil {
+		return Stats{}, errors.New("lzham: compressor closed")
+	}
+	var s C.tf2lzham_stats
+	if _err := C.tf2lzham_compress_strerror(C.tf2lzham_compressor_stats(c.c, &s)); _err != nil {
+		return Stats{}, errors.New("lzham: " + C.GoString(_err))
+	}
+	return makeStats(&s), nil
+}
+
+// Stats returns the statistics for the last call to Decompress (or the last
+// item decompressed by DecompressBatch).
+func (d *Decompressor) Stats() (Stats, error) {
+	if d.d == nil {
+		return Stats{}, errors.New("lzham: decompressor closed")
+	}
+	var s C.tf2lzham_stats
+	if _err := C.tf2lzham_decompress_strerror(C.tf2lzham_decompressor_stats(d.d, &s)); _err != nil {
+		return Stats{}, errors.New("lzham: " + C.GoString(_err))
+	}
+	return makeStats(&s), nil
+}
+
+// Stats returns the statistics for the data written since the Writer was
+// created or reset. After Close, it returns the statistics for the finished
+// stream.
+func (z *Writer) Stats() (Stats, error) {
+	if z.c.c == nil {
+		return z.stats, nil
+	}
+	return z.c.Stats()
+}
+
+// Stats returns the statistics for the data read since the Reader was created
+// or reset.
+func (z *Reader) Stats() (Stats, error) {
+	return z.d.Stats()
+}
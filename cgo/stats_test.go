@@ -0,0 +1,158 @@
+package tf2lzham
+
+import (
+	"bytes"
+	"io"
+	"testing"
+)
+
+func TestStats(t *testing.T) {
+	c, err := NewCompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer c.Close()
+	d, err := NewDecompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer d.Close()
+
+	for _, in := range []testInput{
+		{"records", testRecords(300<<10, 1)},
+		{"random", testRandom(64<<10, 2)},
+	} {
+		comp := make([]byte, compressBound(len(in.data)))
+		n, _, _, err := c.Compress(comp, in.data)
+		if err != nil {
+			t.Fatal(err)
+		}
+		comp = comp[:n]
+		cs, err := c.Stats()
+		if err != nil {
+			t.Fatalf("%s: compressor stats: %v", in.name, err)
+		}
+		if cs.SrcBytes != uint64(len(in.data)) || cs.DstBytes != uint64(n) {
+			t.Errorf("%s: compressor stats: expected %d -> %d bytes, got %d -> %d", in.name, len(in.data), n, cs.SrcBytes, cs.DstBytes)
+		}
+		if cs.Total <= 0 || cs.MatchFinder+cs.Parse+cs.Coding > cs.Total {
+			t.Errorf("%s: compressor stats: stage times %v+%v+%v don't fit in %v", in.name, cs.MatchFinder, cs.Parse, cs.Coding, cs.Total)
+		}
+
+		dst := make([]byte, len(in.data))
+		if _, _, _, err := d.Decompress(dst, comp); err != nil {
+			t.Fatal(err)
+		}
+		ds, err := d.Stats()
+		if err != nil {
+			t.Fatalf("%s: decompressor stats: %v", in.name, err)
+		}
+		if ds.SrcBytes == 0 || ds.SrcBytes > uint64(n) || ds.DstBytes != uint64(len(in.data)) {
+			t.Errorf("%s: decompressor stats: expected up to %d -> %d bytes, got %d -> %d", in.name, n, len(in.data), ds.SrcBytes, ds.DstBytes)
+		}
+		if ds.CompressedBlocks != cs.CompressedBlocks || ds.RawBlocks != cs.RawBlocks {
+			t.Errorf("%s: decompressor stats: expected %d compressed and %d raw blocks, got %d and %d", in.name, cs.CompressedBlocks, cs.RawBlocks, ds.CompressedBlocks, ds.RawBlocks)
+		}
+		if ds.Literals != 0 || ds.TableRebuilds != 0 {
+			t.Errorf("%s: decompressor stats: symbols counted without NewDecompressorStats", in.name)
+		}
+
+		switch in.name {
+		case "records":
+			if cs.CompressedBlocks == 0 || cs.RawBlocks != 0 || cs.Literals == 0 || cs.FullMatches == 0 || cs.RepMatches[0] == 0 {
+				t.Errorf("%s: compressor stats: expected compressed blocks with literals and matches, got %+v", in.name, cs)
+			}
+		case "random":
+			if cs.RawBlocks == 0 {
+				t.Errorf("%s: compressor stats: expected raw blocks, got %+v", in.name, cs)
+			}
+		}
+	}
+
+	c.Close()
+	if _, err := c.Stats(); err == nil {
+		t.Errorf("expected error for a closed compressor")
+	}
+	d.Close()
+	if _, err := d.Stats(); err == nil {
+		t.Errorf("expected error for a closed decompressor")
+	}
+}
+
+func TestStreamStats(t *testing.T) {
+	src := testRecords(300<<10, 1)
+
+	var buf bytes.Buffer
+	w, err := NewWriter(&buf)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if _, err := w.Write(src); err != nil {
+		t.Fatal(err)
+	}
+	if err := w.Close(); err != nil {
+		t.Fatal(err)
+	}
+	// still available after Close
+	if s, err := w.Stats(); err != nil {
+		t.Errorf("writer stats: %v", err)
+	} else if s.SrcBytes != uint64(len(src)) || s.DstBytes != uint64(buf.Len()) {
+		t.Errorf("writer stats: expected %d -> %d bytes, got %d -> %d", len(src), buf.Len(), s.SrcBytes, s.DstBytes)
+	}
+
+	r, err := NewReader(&buf)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer r.Close()
+	if _, err := io.Copy(io.Discard, r); err != nil {
+		t.Fatal(err)
+	}
+	if s, err := r.Stats(); err != nil {
+		t.Errorf("reader stats: %v", err)
+	} else if s.DstBytes != uint64(len(src)) {
+		t.Errorf("reader stats: expected %d bytes, got %d", len(src), s.DstBytes)
+	}
+}
+
+func TestDecompressorStats(t *testing.T) {
+	c, err := NewCompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer c.Close()
+	d, err := NewDecompressorStats()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer d.Close()
+
+	for _, in := range testInputs() {
+		comp := make([]byte, compressBound(len(in.data)))
+		n, _, _, err := c.Compress(comp, in.data)
+		if err != nil {
+			t.Fatal(err)
+		}
+		cs, _ := c.Stats()
+
+		// still a normal decompressor
+		dst := make([]byte, len(in.data))
+		if m, _, _, err := d.Decompress(dst, comp[:n]); err != nil {
+			t.Fatalf("%s: decompress: %v", in.name, err)
+		} else if !bytes.Equal(dst[:m], in.data) {
+			t.Fatalf("%s: decompressed output does not match input", in.name)
+		}
+
+		// the decoded symbols are the ones the compressor coded
+		ds, err := d.Stats()
+		if err != nil {
+			t.Fatalf("%s: stats: %v", in.name, err)
+		}
+		if ds.Literals != cs.Literals || ds.DeltaLiterals != cs.DeltaLiterals || ds.RepMatches != cs.RepMatches || ds.FullMatches != cs.FullMatches || ds.Len2Matches != cs.Len2Matches {
+			t.Errorf("%s: decoded symbols %+v differ from coded symbols %+v", in.name, ds, cs)
+		}
+		if cs.CompressedBlocks != 0 && (ds.TableRebuilds == 0 || ds.TableRebuild <= 0 || ds.TableRebuild > ds.Total) {
+			t.Errorf("%s: expected table rebuilds within the total time, got %d in %v of %v", in.name, ds.TableRebuilds, ds.TableRebuild, ds.Total)
+		}
+	}
+}
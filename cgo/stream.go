@@ -0,0 +1,243 @@
+package tf2lzham
+
+// #include "tf2lzham.h"
+// #include "lzham.h"
+import "C"
+
+import (
+	"errors"
+	"io"
+	"unsafe"
+)
+
+// StreamBufferSize is the size of the buffers used by Reader and Writer.
+const StreamBufferSize = 64 << 10
+
+// Reader decompresses a stream read from an underlying io.Reader. It uses a
+// fixed amount of memory regardless of the stream size.
+type Reader struct {
+	r       io.Reader
+	d       *Decompressor
+	buf     []byte
+	in      []byte // unconsumed input (in buf)
+	eof     bool   // r is at EOF
+	more    bool   // the decompressor needs more input
+	err     error  // sticky error
+	src_len C.size_t
+	dst_len C.size_t
+}
+
+// NewReader returns a Reader which decompresses data from r. It should be
+// closed when it is no longer needed.
+func NewReader(r io.Reader) (*Reader, error) {
+	d, err := NewDecompressor()
+	if err != nil {
+		return nil, err
+	}
+	z := &Reader{
+		d:   d,
+		buf: make([]byte, StreamBufferSize),
+	}
+	if err := z.Reset(r); err != nil {
+		d.Close()
+		return nil, err
+	}
+	return z, nil
+}
+
+// Reset discards the Reader's state and makes it equivalent to the result of
+// NewReader, but reading from r instead.
+func (z *Reader) Reset(r io.Reader) error {
+	if z.d.d == nil {
+		return errors.New("lzham: reader closed")
+	}
+	z.r, z.in, z.eof, z.more, z.err = r, nil, false, true, nil
+	if _err := C.tf2lzham_decompress_strerror(C.tf2lzham_decompressor_reset(z.d.d)); _err != nil {
+		z.err = errors.New("lzham: " + C.GoString(_err))
+	}
+	return z.err
+}
+
+func (z *Reader) Read(p []byte) (int, error) {
+	if z.err != nil {
+		return 0, z.err
+	}
+	if len(p) == 0 {
+		return 0, nil
+	}
+	for {
+		if z.more && len(z.in) == 0 && !z.eof {
+			n, err := z.r.Read(z.buf)
+			z.in = z.buf[:n]
+			if err == io.EOF {
+				z.eof = true
+			} else if err != nil {
+				z.err = err
+				return 0, err
+			}
+			if n == 0 && !z.eof {
+				continue
+			}
+		}
+		var (
+			_dst     *C.uint8_t = (*C.uint8_t)(unsafe.Pointer(&p[0]))
+			_dst_len *C.size_t  = &z.dst_len
+			_src     *C.uint8_t
+			_src_len *C.size_t = &z.src_len
+			_eof     C.int
+		)
+		if len(z.in) != 0 {
+			_src = (*C.uint8_t)(unsafe.Pointer(&z.in[0]))
+		}
+		if z.eof {
+			_eof = 1
+		}
+		*_dst_len = C.size_t(len(p))
+		*_src_len = C.size_t(len(z.in))
+		status := C.tf2lzham_decompressor_stream(z.d.d, _dst, _dst_len, _src, _src_len, _eof)
+		z.in = z.in[*_src_len:]
+		z.more = status == C.LZHAM_DECOMP_STATUS_NEEDS_MORE_INPUT
+		n := int(*_dst_len)
+		switch {
+		case status == C.LZHAM_DECOMP_STATUS_SUCCESS:
+			z.err = io.EOF
+		case status >= C.LZHAM_DECOMP_STATUS_FIRST_FAILURE_CODE:
+			z.err = errors.New("lzham: " + C.GoString(C.tf2lzham_decompress_strerror(status)))
+		case n == 0 && z.more && z.eof && len(z.in) == 0:
+			z.err = io.ErrUnexpectedEOF
+		}
+		if n != 0 || z.err != nil {
+			if n != 0 && z.err == io.EOF {
+				return n, nil
+			}
+			return n, z.err
+		}
+	}
+}
+
+// Close frees the decompressor. It does not close the underlying io.Reader.
+func (z *Reader) Close() error {
+	z.d.Close()
+	if z.err == nil || z.err == io.EOF {
+		z.err = errors.New("lzham: reader closed")
+	}
+	return nil
+}
+
+// Writer compresses data written to it, writing the compressed stream to an
+// underlying io.Writer. It uses a fixed amount of memory regardless of the
+// stream size (other than the compressor state itself).
+type Writer struct {
+	w       io.Writer
+	c       *Compressor
+	buf     []byte
+	err     error // sticky error
+	stats   Stats // of the finished stream, after Close
+	src_len C.size_t
+	dst_len C.size_t
+}
+
+// NewWriter returns a Writer which compresses data to w. The Writer must be
+// closed to finish the stream.
+func NewWriter(w io.Writer) (*Writer, error) {
+	c, err := NewCompressor()
+	if err != nil {
+		return nil, err
+	}
+	return &Writer{
+		w:   w,
+		c:   c,
+		buf: make([]byte, StreamBufferSize),
+	}, nil
+}
+
+// Reset discards the Writer's state and makes it equivalent to the result of
+// NewWriter, but writing to w instead.
+func (z *Writer) Reset(w io.Writer) error {
+	if z.c.c == nil {
+		return errors.New("lzham: writer closed")
+	}
+	z.w, z.err = w, nil
+	if _err := C.tf2lzham_compress_strerror(C.tf2lzham_compressor_reset(z.c.c)); _err != nil {
+		z.err = errors.New("lzham: " + C.GoString(_err))
+	}
+	return z.err
+}
+
+// stream compresses p, writing the output to the underlying writer. After
+// the input has been consumed, flush is done once, then any remaining output
+// is drained without flushing again.
+func (z *Writer) stream(p []byte, flush C.uint32_t) (int, error) {
+	if z.err != nil {
+		return 0, z.err
+	}
+	if z.c.c == nil {
+		return 0, errors.New("lzham: writer closed")
+	}
+	var n int
+	for {
+		var (
+			_dst     *C.uint8_t = (*C.uint8_t)(unsafe.Pointer(&z.buf[0]))
+			_dst_len *C.size_t  = &z.dst_len
+			_src     *C.uint8_t
+			_src_len *C.size_t = &z.src_len
+		)
+		if n != len(p) {
+			_src = (*C.uint8_t)(unsafe.Pointer(&p[n]))
+		}
+		*_dst_len = C.size_t(len(z.buf))
+		*_src_len = C.size_t(len(p) - n)
+		status := C.tf2lzham_compressor_stream(z.c.c, _dst, _dst_len, _src, _src_len, flush)
+		if status >= C.LZHAM_COMP_STATUS_FIRST_FAILURE_CODE {
+			z.err = errors.New("lzham: " + C.GoString(C.tf2lzham_compress_strerror(status)))
+			return n, z.err
+		}
+		n += int(*_src_len)
+		if _, err := z.w.Write(z.buf[:*_dst_len]); err != nil {
+			z.err = err
+			return n, err
+		}
+		if n == len(p) {
+			switch {
+			case status == C.LZHAM_COMP_STATUS_HAS_MORE_OUTPUT:
+				if flush != C.LZHAM_FINISH {
+					flush = C.LZHAM_NO_FLUSH
+				}
+			case status == C.LZHAM_COMP_STATUS_NOT_FINISHED && flush == C.LZHAM_NO_FLUSH:
+			case status == C.LZHAM_COMP_STATUS_NOT_FINISHED && flush == C.LZHAM_FINISH:
+			default:
+				return n, nil
+			}
+		}
+	}
+}
+
+func (z *Writer) Write(p []byte) (int, error) {
+	if len(p) == 0 {
+		return 0, z.err
+	}
+	return z.stream(p, C.LZHAM_NO_FLUSH)
+}
+
+// Flush compresses any pending data and writes it to the underlying writer,
+// aligned to a byte boundary so it can be fully decompressed by a Reader
+// without waiting for more input.
+func (z *Writer) Flush() error {
+	_, err := z.stream(nil, C.LZHAM_SYNC_FLUSH)
+	return err
+}
+
+// Close finishes the stream and frees the compressor. It does not close the
+// underlying io.Writer.
+func (z *Writer) Close() error {
+	if z.c.c == nil {
+		return z.err
+	}
+	_, err := z.stream(nil, C.LZHAM_FINISH)
+	z.stats, _ = z.c.Stats()
+	z.c.Close()
+	if z.err == nil {
+		z.err = errors.New("lzham: writer closed")
+	}
+	return err
+}
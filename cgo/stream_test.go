@@ -0,0 +1,219 @@
+package tf2lzham
+
+import (
+	"bytes"
+	"errors"
+	"io"
+	"math/rand"
+	"testing"
+	"testing/iotest"
+)
+
+// writeStream compresses src with a Writer in pieces of n bytes.
+func writeStream(t *testing.T, src []byte, n int) []byte {
+	t.Helper()
+	var buf bytes.Buffer
+	z, err := NewWriter(&buf)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for b := src; len(b) != 0; {
+		m, err := z.Write(b[:min(n, len(b))])
+		if err != nil {
+			t.Fatalf("write: %v", err)
+		}
+		b = b[m:]
+	}
+	if err := z.Close(); err != nil {
+		t.Fatalf("close: %v", err)
+	}
+	return buf.Bytes()
+}
+
+func TestStream(t *testing.T) {
+	for _, in := range testInputs() {
+		comp := writeStream(t, in.data, 7000)
+
+		// the stream is a normal lzham stream
+		checkDecompress(t, comp, in.data)
+
+		z, err := NewReader(iotest.HalfReader(bytes.NewReader(comp)))
+		if err != nil {
+			t.Fatal(err)
+		}
+		dec, err := io.ReadAll(iotest.OneByteReader(z))
+		if err != nil {
+			t.Fatalf("%s: read: %v", in.name, err)
+		}
+		if !bytes.Equal(dec, in.data) {
+			t.Fatalf("%s: read output does not match input", in.name)
+		}
+		z.Close()
+	}
+}
+
+// errBlocked is returned by a reader which has no more input yet.
+var errBlocked = errors.New("blocked")
+
+func TestStreamFlush(t *testing.T) {
+	part1, part2 := testRecords(100<<10, 1), testRecords(50<<10, 2)
+
+	var buf bytes.Buffer
+	w, err := NewWriter(&buf)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer w.Close()
+	if _, err := w.Write(part1); err != nil {
+		t.Fatal(err)
+	}
+	if err := w.Flush(); err != nil {
+		t.Fatal(err)
+	}
+
+	// everything written before the flush can be read from the output so far
+	flushed := append([]byte(nil), buf.Bytes()...)
+	r, err := NewReader(io.MultiReader(bytes.NewReader(flushed), iotest.ErrReader(errBlocked)))
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer r.Close()
+	dec := make([]byte, len(part1))
+	if _, err := io.ReadFull(r, dec); err != nil {
+		t.Fatalf("read flushed data: %v", err)
+	}
+	if !bytes.Equal(dec, part1) {
+		t.Fatalf("flushed data does not match input")
+	}
+
+	if _, err := w.Write(part2); err != nil {
+		t.Fatal(err)
+	}
+	if err := w.Close(); err != nil {
+		t.Fatal(err)
+	}
+	if !bytes.HasPrefix(buf.Bytes(), flushed) {
+		t.Fatalf("flushed output changed")
+	}
+	checkDecompress(t, buf.Bytes(), append(part1, part2...))
+}
+
+func TestStreamFlushPipe(t *testing.T) {
+	// several times the dictionary size (1 MiB), flushed in pieces of up to 200 KiB
+	src := append(testRecords(2<<20, 1), testRandom(600<<10, 2)...)
+	src = append(src, testRecords(1<<20, 3)...)
+	var pieces [][]byte
+	for b, r := src, rand.New(rand.NewSource(4)); len(b) != 0; {
+		n := min(len(b), 1+r.Intn(200<<10))
+		pieces, b = append(pieces, b[:n]), b[n:]
+	}
+
+	// each piece is written after the previous one was read, so the reader
+	// blocks if a flush didn't give it everything written so far
+	pr, pw := io.Pipe()
+	var buf bytes.Buffer
+	next, done := make(chan struct{}), make(chan error, 1)
+	go func() {
+		err := func() error {
+			w, err := NewWriter(io.MultiWriter(pw, &buf))
+			if err != nil {
+				return err
+			}
+			for _, p := range pieces {
+				if _, err := w.Write(p); err != nil {
+					return err
+				}
+				if err := w.Flush(); err != nil {
+					return err
+				}
+				if _, ok := <-next; !ok {
+					return nil
+				}
+			}
+			return w.Close()
+		}()
+		pw.CloseWithError(err)
+		done <- err
+	}()
+	defer close(next)
+
+	r, err := NewReader(pr)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer r.Close()
+	for i, p := range pieces {
+		dec := make([]byte, len(p))
+		if _, err := io.ReadFull(r, dec); err != nil {
+			t.Fatalf("piece %d: read: %v", i, err)
+		}
+		if !bytes.Equal(dec, p) {
+			t.Fatalf("piece %d: read output does not match input", i)
+		}
+		next <- struct{}{}
+	}
+	if n, err := r.Read(make([]byte, 1)); n != 0 || err != io.EOF {
+		t.Fatalf("expected EOF at the end of the stream, got %d %v", n, err)
+	}
+	if err := <-done; err != nil {
+		t.Fatalf("write: %v", err)
+	}
+	checkDecompress(t, buf.Bytes(), src)
+}
+
+func TestStreamReset(t *testing.T) {
+	src1, src2 := testRecords(200<<10, 1), testRecords(20<<10, 2)
+
+	var buf1, buf2 bytes.Buffer
+	w, err := NewWriter(&buf1)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if _, err := w.Write(src1[:1000]); err != nil {
+		t.Fatal(err)
+	}
+	if err := w.Reset(&buf1); err != nil {
+		t.Fatal(err)
+	}
+	buf1.Reset()
+	for i, b := range [][]byte{src1, src2} {
+		if i == 1 {
+			if err := w.Reset(&buf2); err != nil {
+				t.Fatal(err)
+			}
+		}
+		if _, err := w.Write(b); err != nil {
+			t.Fatal(err)
+		}
+		if err := w.Flush(); err != nil {
+			t.Fatal(err)
+		}
+	}
+	if err := w.Close(); err != nil {
+		t.Fatal(err)
+	}
+	if err := w.Reset(&buf2); err == nil {
+		t.Errorf("expected error resetting a closed writer")
+	}
+
+	// buf1 wasn't finished, so it's truncated
+	r, err := NewReader(bytes.NewReader(buf1.Bytes()))
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer r.Close()
+	if dec, err := io.ReadAll(r); err == nil {
+		t.Errorf("expected error for a truncated stream")
+	} else if !bytes.HasPrefix(src1, dec) {
+		t.Errorf("truncated stream output does not match input")
+	}
+
+	if err := r.Reset(bytes.NewReader(buf2.Bytes())); err != nil {
+		t.Fatal(err)
+	}
+	if dec, err := io.ReadAll(r); err != nil {
+		t.Errorf("read after reset: %v", err)
+	} else if !bytes.Equal(dec, src2) {
+		t.Errorf("read output does not match input after reset")
+	}
+}
@@ -3,17 +3,21 @@
 
 static const lzham_uint32 tf2lzham_dict_size = 20; // required for compatibility
 
+// each context takes all of its memory from its own arena (see
+// LZHAM_COMP_FLAG_USE_ARENA), so compressing on many goroutines at once doesn't
+// contend in malloc, and freeing a context only frees a few chunks
 static const lzham_compress_params tf2lzham_compress_params = {
     .m_struct_size = sizeof(lzham_compress_params),
     .m_dict_size_log2 = tf2lzham_dict_size,
     .m_level = LZHAM_COMP_LEVEL_UBER,
-    .m_compress_flags = LZHAM_COMP_FLAG_DETERMINISTIC_PARSING,
+    .m_max_helper_threads = -1, // none unless built with LZHAM_THREADING
+    .m_compress_flags = LZHAM_COMP_FLAG_DETERMINISTIC_PARSING | LZHAM_COMP_FLAG_USE_ARENA,
 };
 
 static const lzham_decompress_params tf2lzham_decompress_params = {
     .m_struct_size = sizeof(lzham_decompress_params),
     .m_dict_size_log2 = 20,
-    .m_decompress_flags = LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED | LZHAM_DECOMP_FLAG_COMPUTE_ADLER32 | LZHAM_DECOMP_FLAG_COMPUTE_CRC32,
+    .m_decompress_flags = LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED | LZHAM_DECOMP_FLAG_COMPUTE_ADLER32 | LZHAM_DECOMP_FLAG_COMPUTE_CRC32 | LZHAM_DECOMP_FLAG_USE_ARENA,
 };
 
 #ifdef __wasm__
@@ -24,14 +28,203 @@ extern "C" void *tf2lzham_malloc(size_t sz) {
     return operator new(sz);
 }
 
+extern "C" void tf2lzham_free(void *ptr) {
+    operator delete(ptr);
+}
+
 extern "C" uint32_t tf2lzham_compress(uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out) {
     return lzham_compress_memory(&tf2lzham_compress_params, dst, dst_len, src, src_len, adler32_out, crc32_out);
 }
 
+// flags which don't change the stream format (i.e., everything except writing a
+// zlib header)
+static const lzham_uint32 tf2lzham_compress_flags_mask = LZHAM_COMP_FLAG_FORCE_POLAR_CODING | LZHAM_COMP_FLAG_EXTREME_PARSING | LZHAM_COMP_FLAG_DETERMINISTIC_PARSING | LZHAM_COMP_FLAG_TRADEOFF_DECOMPRESSION_RATE_FOR_COMP_RATIO;
+
+// sets the level and flags in params, returning false if the flags would make
+// the output incompatible (the level is validated by lzham)
+static bool tf2lzham_compress_params_level(lzham_compress_params *params, uint32_t level, uint32_t flags) {
+    *params = tf2lzham_compress_params;
+    params->m_level = static_cast<lzham_compress_level>(level);
+    params->m_compress_flags = flags | LZHAM_COMP_FLAG_USE_ARENA;
+    return !(flags & ~tf2lzham_compress_flags_mask);
+}
+
+extern "C" uint32_t tf2lzham_compress_level(uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out, uint32_t level, uint32_t flags) {
+    lzham_compress_params params;
+    if (!tf2lzham_compress_params_level(&params, level, flags)) {
+        return LZHAM_COMP_STATUS_INVALID_PARAMETER;
+    }
+    return lzham_compress_memory(&params, dst, dst_len, src, src_len, adler32_out, crc32_out);
+}
+
+extern "C" uint32_t tf2lzham_compress_chunk(uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out, uint32_t chunk_flags, uint32_t adler32) {
+    lzham_compress_state_ptr c = lzham_compress_init(&tf2lzham_compress_params);
+    if (!c) {
+        return LZHAM_COMP_STATUS_FAILED_INITIALIZING;
+    }
+    uint32_t status = lzham_compress_memory_chunk(c, dst, dst_len, src, src_len, chunk_flags, adler32, adler32_out, crc32_out);
+    delete lzham_compress_deinit(c);
+    return status;
+}
+
+extern "C" tf2lzham_compressor_ptr tf2lzham_compressor_new(void) {
+    return lzham_compress_init(&tf2lzham_compress_params);
+}
+
+extern "C" tf2lzham_compressor_ptr tf2lzham_compressor_new_level(uint32_t level, uint32_t flags) {
+    lzham_compress_params params;
+    if (!tf2lzham_compress_params_level(&params, level, flags)) {
+        return NULL;
+    }
+    return lzham_compress_init(&params);
+}
+
+extern "C" uint32_t tf2lzham_compressor_compress(tf2lzham_compressor_ptr c, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out) {
+    return lzham_compress_memory_reinit(c, dst, dst_len, src, src_len, adler32_out, crc32_out);
+}
+
+// compresses each item with the same compressor, which is reset between items;
+// returns the status of the first failed item, or LZHAM_COMP_STATUS_SUCCESS
+extern "C" uint32_t tf2lzham_compressor_compress_batch(tf2lzham_compressor_ptr c, tf2lzham_batch_item *items, size_t n) {
+    uint32_t status = LZHAM_COMP_STATUS_SUCCESS;
+    for (size_t i = 0; i < n; i++) {
+        tf2lzham_batch_item *it = &items[i];
+        it->status = lzham_compress_memory_reinit(c, it->dst, &it->dst_len, it->src, it->src_len, &it->adler32, &it->crc32);
+        if (it->status != LZHAM_COMP_STATUS_SUCCESS && status == LZHAM_COMP_STATUS_SUCCESS) {
+            status = it->status;
+        }
+    }
+    return status;
+}
+
+// compresses a chunk of a stream made by concatenating independently compressed
+// chunks (see lzham_compress_memory_chunk); all chunks must use the same level
+// and flags
+extern "C" uint32_t tf2lzham_compressor_compress_chunk(tf2lzham_compressor_ptr c, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out, uint32_t chunk_flags, uint32_t adler32) {
+    return lzham_compress_memory_chunk(c, dst, dst_len, src, src_len, chunk_flags, adler32, adler32_out, crc32_out);
+}
+
+extern "C" uint32_t tf2lzham_compressor_reset(tf2lzham_compressor_ptr c) {
+    return lzham_compress_reinit(c) ? LZHAM_COMP_STATUS_SUCCESS : LZHAM_COMP_STATUS_FAILED_INITIALIZING;
+}
+
+extern "C" uint32_t tf2lzham_compressor_stream(tf2lzham_compressor_ptr c, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t *src_len, uint32_t flush) {
+    return lzham_compress2(c, src, src_len, dst, dst_len, static_cast<lzham_flush_t>(flush));
+}
+
+// gets the statistics since the compressor was last reset (i.e., for the last
+// call to tf2lzham_compressor_compress or tf2lzham_compressor_compress_chunk)
+extern "C" uint32_t tf2lzham_compressor_stats(tf2lzham_compressor_ptr c, tf2lzham_stats *stats) {
+    lzham_compress_stats s = {};
+    s.m_struct_size = sizeof(lzham_compress_stats);
+    if (!stats || !lzham_compress_get_stats(c, &s)) {
+        return LZHAM_COMP_STATUS_INVALID_PARAMETER;
+    }
+    *stats = {};
+    stats->total_ns = s.m_total_ns;
+    stats->match_finder_ns = s.m_match_finder_ns;
+    stats->parse_ns = s.m_parse_ns;
+    stats->coding_ns = s.m_coding_ns;
+    stats->src_bytes = s.m_src_bytes;
+    stats->dst_bytes = s.m_dst_bytes;
+    stats->compressed_blocks = s.m_compressed_blocks;
+    stats->raw_blocks = s.m_raw_blocks;
+    stats->literals = s.m_literals;
+    stats->delta_literals = s.m_delta_literals;
+    for (int i = 0; i < 4; i++) {
+        stats->rep_matches[i] = s.m_rep_matches[i];
+    }
+    stats->full_matches = s.m_full_matches;
+    stats->len2_matches = s.m_len2_matches;
+    stats->table_rebuilds = s.m_table_rebuilds;
+    stats->bytes_allocated = s.m_bytes_allocated;
+    stats->allocs = s.m_allocs;
+    stats->underlying_allocs = s.m_underlying_allocs;
+    return LZHAM_COMP_STATUS_SUCCESS;
+}
+
+extern "C" void tf2lzham_compressor_free(tf2lzham_compressor_ptr c) {
+    delete lzham_compress_deinit(c); // deinit returns heap-allocated checksums
+}
+
 extern "C" uint32_t tf2lzham_decompress(uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out) {
     return lzham_decompress_memory(&tf2lzham_decompress_params, dst, dst_len, src, src_len, adler32_out, crc32_out);
 }
 
+extern "C" tf2lzham_decompressor_ptr tf2lzham_decompressor_new(void) {
+    return lzham_decompress_init(&tf2lzham_decompress_params);
+}
+
+// like tf2lzham_decompressor_new, but also counts the decoded symbols and table
+// rebuilds (which makes decompression slightly slower)
+extern "C" tf2lzham_decompressor_ptr tf2lzham_decompressor_new_stats(void) {
+    lzham_decompress_params params = tf2lzham_decompress_params;
+    params.m_decompress_flags |= LZHAM_DECOMP_FLAG_COLLECT_STATS;
+    return lzham_decompress_init(&params);
+}
+
+extern "C" uint32_t tf2lzham_decompressor_decompress(tf2lzham_decompressor_ptr d, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out) {
+    return lzham_decompress_memory_reinit(d, dst, dst_len, src, src_len, adler32_out, crc32_out);
+}
+
+// decompresses each item with the same decompressor, which is reinitialized
+// between items; returns the status of the first failed item, or
+// LZHAM_DECOMP_STATUS_SUCCESS
+extern "C" uint32_t tf2lzham_decompressor_decompress_batch(tf2lzham_decompressor_ptr d, tf2lzham_batch_item *items, size_t n) {
+    uint32_t status = LZHAM_DECOMP_STATUS_SUCCESS;
+    for (size_t i = 0; i < n; i++) {
+        tf2lzham_batch_item *it = &items[i];
+        it->status = lzham_decompress_memory_reinit(d, it->dst, &it->dst_len, it->src, it->src_len, &it->adler32, &it->crc32);
+        if (it->status != LZHAM_DECOMP_STATUS_SUCCESS && status == LZHAM_DECOMP_STATUS_SUCCESS) {
+            status = it->status;
+        }
+    }
+    return status;
+}
+
+extern "C" uint32_t tf2lzham_decompressor_reset(tf2lzham_decompressor_ptr d) {
+    lzham_decompress_params params = tf2lzham_decompress_params;
+    params.m_decompress_flags &= ~LZHAM_DECOMP_FLAG_OUTPUT_UNBUFFERED; // streaming requires the dictionary buffer
+    return lzham_decompress_reinit(d, &params) ? LZHAM_DECOMP_STATUS_SUCCESS : LZHAM_DECOMP_STATUS_FAILED_INITIALIZING;
+}
+
+extern "C" uint32_t tf2lzham_decompressor_stream(tf2lzham_decompressor_ptr d, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t *src_len, int eof) {
+    return lzham_decompress(d, src, src_len, dst, dst_len, eof ? 1 : 0);
+}
+
+// gets the statistics since the decompressor was last reset (i.e., for the last
+// call to tf2lzham_decompressor_decompress)
+extern "C" uint32_t tf2lzham_decompressor_stats(tf2lzham_decompressor_ptr d, tf2lzham_stats *stats) {
+    lzham_decompress_stats s = {};
+    s.m_struct_size = sizeof(lzham_decompress_stats);
+    if (!stats || !lzham_decompress_get_stats(d, &s)) {
+        return LZHAM_DECOMP_STATUS_INVALID_PARAMETER;
+    }
+    *stats = {};
+    stats->total_ns = s.m_total_ns;
+    stats->src_bytes = s.m_src_bytes;
+    stats->dst_bytes = s.m_dst_bytes;
+    stats->compressed_blocks = s.m_compressed_blocks;
+    stats->raw_blocks = s.m_raw_blocks;
+    stats->literals = s.m_literals;
+    stats->delta_literals = s.m_delta_literals;
+    for (int i = 0; i < 4; i++) {
+        stats->rep_matches[i] = s.m_rep_matches[i];
+    }
+    stats->full_matches = s.m_full_matches;
+    stats->len2_matches = s.m_len2_matches;
+    stats->table_rebuilds = s.m_table_rebuilds;
+    stats->table_rebuild_ns = s.m_table_rebuild_ns;
+    stats->bytes_allocated = s.m_bytes_allocated;
+    stats->allocs = s.m_allocs;
+    stats->underlying_allocs = s.m_underlying_allocs;
+    return LZHAM_DECOMP_STATUS_SUCCESS;
+}
+
+extern "C" void tf2lzham_decompressor_free(tf2lzham_decompressor_ptr d) {
+    delete lzham_decompress_deinit(d); // deinit returns heap-allocated checksums
+}
+
 extern "C" const char *tf2lzham_compress_strerror(uint32_t status) {
     switch (status) {
     // indeterminate
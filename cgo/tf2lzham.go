@@ -7,10 +7,31 @@ import "C"
 
 import (
 	"errors"
+	"runtime"
+	"sync"
 	"unsafe"
 )
 
+// decompressorPool holds initialized decompressors for Decompress.
+// Decompressors dropped by the pool are freed by their finalizer.
+var decompressorPool = sync.Pool{
+	New: func() any {
+		if d, err := NewDecompressor(); err == nil {
+			return d
+		}
+		return nil
+	},
+}
+
 func Decompress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+	if d, _ := decompressorPool.Get().(*Decompressor); d != nil {
+		defer decompressorPool.Put(d)
+		return d.Decompress(dst, src)
+	}
+	return decompress(dst, src)
+}
+
+func decompress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
 	if len(dst) == 0 || len(src) == 0 {
 		return 0, 0, 0, errors.New("lzham: zero-length buffer")
 	}
@@ -29,7 +50,108 @@ func Decompress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
 	return int(*_dst_len), adler32, crc32, nil
 }
 
+// compressorPool holds initialized compressors for Compress. Compressors
+// dropped by the pool are freed by their finalizer.
+var compressorPool = sync.Pool{
+	New: func() any {
+		if c, err := NewCompressor(); err == nil {
+			return c
+		}
+		return nil
+	},
+}
+
 func Compress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+	if c, _ := compressorPool.Get().(*Compressor); c != nil {
+		defer compressorPool.Put(c)
+		return c.Compress(dst, src)
+	}
+	return compress(dst, src)
+}
+
+// Level is a compression level. Output at any level can be decompressed by the
+// game, since only the dictionary size needs to match.
+type Level uint32
+
+const (
+	LevelFastest Level = iota
+	LevelFaster
+	LevelDefault
+	LevelBetter
+	LevelUber // used by Compress
+
+	// LevelGreedy uses hash chains and a greedy parse instead of the match
+	// finder and near-optimal parser. It is several times faster than
+	// LevelFastest on records, runs, and incompressible data, but has a worse
+	// ratio, and can be slower on noisy binary data with many short matches.
+	LevelGreedy
+)
+
+// Flags are compression flags. Flags which would change the stream format are
+// not supported.
+type Flags uint32
+
+const (
+	FlagForcePolarCoding          Flags = 1 << 0 // use polar codes instead of huffman for slightly faster decompression
+	FlagExtremeParsing            Flags = 1 << 1 // better ratio, but much slower
+	FlagDeterministicParsing      Flags = 1 << 2 // same output for the same input regardless of threading (used by Compress)
+	FlagTradeoffDecompressionRate Flags = 1 << 4 // better ratio, but slower decompression
+
+	flagsMask = FlagForcePolarCoding | FlagExtremeParsing | FlagDeterministicParsing | FlagTradeoffDecompressionRate
+)
+
+func (level Level) valid(flags Flags) bool {
+	return level <= LevelGreedy && flags&^flagsMask == 0
+}
+
+type compressorPoolKey struct {
+	level Level
+	flags Flags
+}
+
+// compressorPools holds a *sync.Pool of compressors for each level and flags
+// used with CompressLevel, other than the defaults used by Compress.
+var compressorPools sync.Map
+
+func getCompressorPool(level Level, flags Flags) *sync.Pool {
+	if level == LevelUber && flags == FlagDeterministicParsing {
+		return &compressorPool
+	}
+	k := compressorPoolKey{level, flags}
+	if p, ok := compressorPools.Load(k); ok {
+		return p.(*sync.Pool)
+	}
+	p, _ := compressorPools.LoadOrStore(k, &sync.Pool{
+		New: func() any {
+			if c, err := NewCompressorLevel(level, flags); err == nil {
+				return c
+			}
+			return nil
+		},
+	})
+	return p.(*sync.Pool)
+}
+
+// CompressLevel is like Compress, but with the specified compression level and
+// flags. Compress is equivalent to CompressLevel with LevelUber and
+// FlagDeterministicParsing.
+func CompressLevel(dst, src []byte, level Level, flags Flags) (n int, adler32, crc32 uint32, err error) {
+	if !level.valid(flags) {
+		return 0, 0, 0, errors.New("lzham: invalid argument")
+	}
+	p := getCompressorPool(level, flags)
+	if c, _ := p.Get().(*Compressor); c != nil {
+		defer p.Put(c)
+		return c.Compress(dst, src)
+	}
+	return compressLevel(dst, src, level, flags)
+}
+
+func compress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+	return compressLevel(dst, src, LevelUber, FlagDeterministicParsing)
+}
+
+func compressLevel(dst, src []byte, level Level, flags Flags) (n int, adler32, crc32 uint32, err error) {
 	if len(dst) == 0 || len(src) == 0 {
 		return 0, 0, 0, errors.New("lzham: zero-length buffer")
 	}
@@ -42,8 +164,149 @@ func Compress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
 		_crc32_out   *C.uint32_t = (*C.uint32_t)(&crc32)
 	)
 	*_dst_len = C.size_t(len(dst))
-	if _err := C.tf2lzham_compress_strerror(C.tf2lzham_compress(_dst, _dst_len, _src, _src_len, _adler32_out, _crc32_out)); _err != nil {
+	if _err := C.tf2lzham_compress_strerror(C.tf2lzham_compress_level(_dst, _dst_len, _src, _src_len, _adler32_out, _crc32_out, C.uint32_t(level), C.uint32_t(flags))); _err != nil {
 		return 0, 0, 0, errors.New("lzham: " + C.GoString(_err))
 	}
 	return int(*_dst_len), adler32, crc32, nil
 }
+
+// Compressor is a reusable compressor. Its dictionary and match finder are
+// allocated once and reset for each call to Compress, which is much faster
+// than initializing a new compressor for every buffer. It is not safe for
+// concurrent use.
+type Compressor struct {
+	c           C.tf2lzham_compressor_ptr
+	dst_len     C.size_t
+	adler32_out C.uint32_t
+	crc32_out   C.uint32_t
+}
+
+// NewCompressor initializes a new Compressor. The returned Compressor should
+// be closed when it is no longer needed, but it will also be freed when it is
+// garbage collected.
+func NewCompressor() (*Compressor, error) {
+	c := C.tf2lzham_compressor_new()
+	if c == nil {
+		return nil, errors.New("lzham: initialization failed")
+	}
+	x := &Compressor{c: c}
+	runtime.SetFinalizer(x, (*Compressor).Close)
+	return x, nil
+}
+
+// NewCompressorLevel is like NewCompressor, but with the specified compression
+// level and flags (see CompressLevel).
+func NewCompressorLevel(level Level, flags Flags) (*Compressor, error) {
+	if !level.valid(flags) {
+		return nil, errors.New("lzham: invalid argument")
+	}
+	c := C.tf2lzham_compressor_new_level(C.uint32_t(level), C.uint32_t(flags))
+	if c == nil {
+		return nil, errors.New("lzham: initialization failed")
+	}
+	x := &Compressor{c: c}
+	runtime.SetFinalizer(x, (*Compressor).Close)
+	return x, nil
+}
+
+// Compress is like the package-level Compress function, but reuses the
+// compressor state.
+func (c *Compressor) Compress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+	if c.c == nil {
+		return 0, 0, 0, errors.New("lzham: compressor closed")
+	}
+	if len(dst) == 0 || len(src) == 0 {
+		return 0, 0, 0, errors.New("lzham: zero-length buffer")
+	}
+	var (
+		_dst         *C.uint8_t  = (*C.uint8_t)(unsafe.Pointer(&dst[0]))
+		_src         *C.uint8_t  = (*C.uint8_t)(unsafe.Pointer(&src[0]))
+		_dst_len     *C.size_t   = &c.dst_len
+		_src_len     C.size_t    = C.size_t(len(src))
+		_adler32_out *C.uint32_t = &c.adler32_out
+		_crc32_out   *C.uint32_t = &c.crc32_out
+	)
+	*_dst_len = C.size_t(len(dst))
+	if _err := C.tf2lzham_compress_strerror(C.tf2lzham_compressor_compress(c.c, _dst, _dst_len, _src, _src_len, _adler32_out, _crc32_out)); _err != nil {
+		return 0, 0, 0, errors.New("lzham: " + C.GoString(_err))
+	}
+	return int(*_dst_len), uint32(*_adler32_out), uint32(*_crc32_out), nil
+}
+
+// Close frees the compressor. It is safe to call Close more than once.
+func (c *Compressor) Close() {
+	if c.c != nil {
+		C.tf2lzham_compressor_free(c.c)
+		c.c = nil
+		runtime.SetFinalizer(c, nil)
+	}
+}
+
+// Decompressor is a reusable decompressor. It is reinitialized for each call
+// to Decompress, and does not allocate any memory after the first call. It is
+// not safe for concurrent use.
+type Decompressor struct {
+	d           C.tf2lzham_decompressor_ptr
+	dst_len     C.size_t
+	adler32_out C.uint32_t
+	crc32_out   C.uint32_t
+}
+
+// NewDecompressor initializes a new Decompressor. The returned Decompressor
+// should be closed when it is no longer needed, but it will also be freed when
+// it is garbage collected.
+func NewDecompressor() (*Decompressor, error) {
+	d := C.tf2lzham_decompressor_new()
+	if d == nil {
+		return nil, errors.New("lzham: initialization failed")
+	}
+	x := &Decompressor{d: d}
+	runtime.SetFinalizer(x, (*Decompressor).Close)
+	return x, nil
+}
+
+// NewDecompressorStats is like NewDecompressor, but the Decompressor also
+// counts the decoded symbols and table rebuilds (see Stats), which makes
+// decompression slightly slower.
+func NewDecompressorStats() (*Decompressor, error) {
+	d := C.tf2lzham_decompressor_new_stats()
+	if d == nil {
+		return nil, errors.New("lzham: initialization failed")
+	}
+	x := &Decompressor{d: d}
+	runtime.SetFinalizer(x, (*Decompressor).Close)
+	return x, nil
+}
+
+// Decompress is like the package-level Decompress function, but reuses the
+// decompressor state.
+func (d *Decompressor) Decompress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+	if d.d == nil {
+		return 0, 0, 0, errors.New("lzham: decompressor closed")
+	}
+	if len(dst) == 0 || len(src) == 0 {
+		return 0, 0, 0, errors.New("lzham: zero-length buffer")
+	}
+	var (
+		_dst         *C.uint8_t  = (*C.uint8_t)(unsafe.Pointer(&dst[0]))
+		_src         *C.uint8_t  = (*C.uint8_t)(unsafe.Pointer(&src[0]))
+		_dst_len     *C.size_t   = &d.dst_len
+		_src_len     C.size_t    = C.size_t(len(src))
+		_adler32_out *C.uint32_t = &d.adler32_out
+		_crc32_out   *C.uint32_t = &d.crc32_out
+	)
+	*_dst_len = C.size_t(len(dst))
+	if _err := C.tf2lzham_decompress_strerror(C.tf2lzham_decompressor_decompress(d.d, _dst, _dst_len, _src, _src_len, _adler32_out, _crc32_out)); _err != nil {
+		return 0, 0, 0, errors.New("lzham: " + C.GoString(_err))
+	}
+	return int(*_dst_len), uint32(*_adler32_out), uint32(*_crc32_out), nil
+}
+
+// Close frees the decompressor. It is safe to call Close more than once.
+func (d *Decompressor) Close() {
+	if d.d != nil {
+		C.tf2lzham_decompressor_free(d.d)
+		d.d = nil
+		runtime.SetFinalizer(d, nil)
+	}
+}
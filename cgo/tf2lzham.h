@@ -7,9 +7,67 @@
 extern "C" {
 #endif
 
+typedef void *tf2lzham_compressor_ptr;
+typedef void *tf2lzham_decompressor_ptr;
+
+typedef struct tf2lzham_batch_item {
+    uint8_t *dst;
+    size_t dst_len; // in: dst capacity, out: output size
+    const uint8_t *src;
+    size_t src_len;
+    uint32_t status;
+    uint32_t adler32;
+    uint32_t crc32;
+} tf2lzham_batch_item;
+
+// statistics for the last operation (or the stream so far); times are in
+// nanoseconds, the compression-only fields are zero for decompression, and the
+// symbol counts are only filled in for decompressors created with
+// tf2lzham_decompressor_new_stats
+typedef struct tf2lzham_stats {
+    uint64_t total_ns;
+    uint64_t match_finder_ns;
+    uint64_t parse_ns;
+    uint64_t coding_ns;
+    uint64_t src_bytes;
+    uint64_t dst_bytes;
+    uint64_t compressed_blocks;
+    uint64_t raw_blocks;
+    uint64_t literals;
+    uint64_t delta_literals;
+    uint64_t rep_matches[4];
+    uint64_t full_matches; // including len2_matches
+    uint64_t len2_matches;
+    uint64_t table_rebuilds;
+    uint64_t table_rebuild_ns; // decompression only
+    uint64_t bytes_allocated;
+    uint64_t allocs;
+    uint64_t underlying_allocs; // with the arena, only its chunks
+} tf2lzham_stats;
+
 TF2LZHAM_EXPORT void *tf2lzham_malloc(size_t sz);
+TF2LZHAM_EXPORT void tf2lzham_free(void *ptr);
 TF2LZHAM_EXPORT uint32_t tf2lzham_compress(uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out);
 TF2LZHAM_EXPORT uint32_t tf2lzham_decompress(uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out);
+TF2LZHAM_EXPORT uint32_t tf2lzham_compress_level(uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out, uint32_t level, uint32_t flags);
+TF2LZHAM_EXPORT uint32_t tf2lzham_compress_chunk(uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out, uint32_t chunk_flags, uint32_t adler32);
+TF2LZHAM_EXPORT tf2lzham_compressor_ptr tf2lzham_compressor_new(void);
+TF2LZHAM_EXPORT tf2lzham_compressor_ptr tf2lzham_compressor_new_level(uint32_t level, uint32_t flags);
+TF2LZHAM_EXPORT uint32_t tf2lzham_compressor_compress(tf2lzham_compressor_ptr c, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out);
+TF2LZHAM_EXPORT uint32_t tf2lzham_compressor_compress_batch(tf2lzham_compressor_ptr c, tf2lzham_batch_item *items, size_t n);
+TF2LZHAM_EXPORT uint32_t tf2lzham_compressor_compress_chunk(tf2lzham_compressor_ptr c, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out, uint32_t chunk_flags, uint32_t adler32);
+TF2LZHAM_EXPORT uint32_t tf2lzham_compressor_reset(tf2lzham_compressor_ptr c);
+TF2LZHAM_EXPORT uint32_t tf2lzham_compressor_stream(tf2lzham_compressor_ptr c, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t *src_len, uint32_t flush);
+TF2LZHAM_EXPORT uint32_t tf2lzham_compressor_stats(tf2lzham_compressor_ptr c, tf2lzham_stats *stats);
+TF2LZHAM_EXPORT void tf2lzham_compressor_free(tf2lzham_compressor_ptr c);
+TF2LZHAM_EXPORT tf2lzham_decompressor_ptr tf2lzham_decompressor_new(void);
+TF2LZHAM_EXPORT tf2lzham_decompressor_ptr tf2lzham_decompressor_new_stats(void);
+TF2LZHAM_EXPORT uint32_t tf2lzham_decompressor_decompress(tf2lzham_decompressor_ptr d, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t src_len, uint32_t *adler32_out, uint32_t *crc32_out);
+TF2LZHAM_EXPORT uint32_t tf2lzham_decompressor_decompress_batch(tf2lzham_decompressor_ptr d, tf2lzham_batch_item *items, size_t n);
+TF2LZHAM_EXPORT uint32_t tf2lzham_decompressor_reset(tf2lzham_decompressor_ptr d);
+TF2LZHAM_EXPORT uint32_t tf2lzham_decompressor_stream(tf2lzham_decompressor_ptr d, uint8_t *dst, size_t *dst_len, const uint8_t *src, size_t *src_len, int eof);
+TF2LZHAM_EXPORT uint32_t tf2lzham_decompressor_stats(tf2lzham_decompressor_ptr d, tf2lzham_stats *stats);
+TF2LZHAM_EXPORT void tf2lzham_decompressor_free(tf2lzham_decompressor_ptr d);
 TF2LZHAM_EXPORT const char *tf2lzham_compress_strerror(uint32_t status);
 TF2LZHAM_EXPORT const char *tf2lzham_decompress_strerror(uint32_t status);
 
@@ -0,0 +1,384 @@
+package tf2lzham
+
+import (
+	"bytes"
+	"encoding/binary"
+	"fmt"
+	"hash/adler32"
+	"hash/crc32"
+	"math/rand"
+	"testing"
+)
+
+type testInput struct {
+	name string
+	data []byte
+}
+
+// testInputs returns generated inputs from a single byte to several blocks,
+// including incompressible data (which is stored in raw blocks).
+func testInputs() []testInput {
+	var in []testInput
+	for _, n := range []int{1, 16, 300, 4 << 10, 300 << 10} {
+		in = append(in, testInput{fmt.Sprintf("records-%d", n), testRecords(n, 1)})
+	}
+	for _, n := range []int{16, 64 << 10} {
+		in = append(in, testInput{fmt.Sprintf("random-%d", n), testRandom(n, 2)})
+	}
+	in = append(in, testInput{"zeros-1048576", make([]byte, 1<<20)})
+	return in
+}
+
+// testRecords generates compressible fixed-size records.
+func testRecords(n int, seed int64) []byte {
+	r := rand.New(rand.NewSource(seed))
+	names := []string{"mp_weapon_r97", "mp_weapon_car", "mp_weapon_wingman", "mp_titanweapon_xo16"}
+	b := make([]byte, 0, n+64)
+	for len(b) < n {
+		b = binary.LittleEndian.AppendUint32(b, uint32(r.Intn(1000000)))
+		b = binary.LittleEndian.AppendUint16(b, uint16(r.Intn(1000)))
+		b = append(b, names[r.Intn(len(names))]...)
+		b = append(b, make([]byte, 24)...)
+	}
+	return b[:n]
+}
+
+// testRandom generates incompressible data.
+func testRandom(n int, seed int64) []byte {
+	b := make([]byte, n)
+	rand.New(rand.NewSource(seed)).Read(b)
+	return b
+}
+
+// testSparse generates mostly zero bytes with scattered values and short runs.
+func testSparse(n int, seed int64) []byte {
+	r := rand.New(rand.NewSource(seed))
+	b := make([]byte, n)
+	for i := 0; i < n; i++ {
+		switch x := r.Intn(256); {
+		case x < 4:
+			b[i] = byte(r.Intn(256))
+		case x == 4:
+			v := byte(r.Intn(256))
+			for j := r.Intn(32); j > 0 && i < n; j-- {
+				b[i] = v
+				i++
+			}
+		}
+	}
+	return b
+}
+
+// compressBound returns a dst size large enough for compressing n bytes.
+func compressBound(n int) int {
+	return n + n/1024 + 128
+}
+
+// checkDecompress checks that comp decompresses to src with Decompress.
+func checkDecompress(t *testing.T, comp, src []byte) {
+	t.Helper()
+	dst := make([]byte, len(src))
+	n, adler, _, err := Decompress(dst, comp)
+	if err != nil {
+		t.Fatalf("decompress: %v", err)
+	}
+	if !bytes.Equal(dst[:n], src) {
+		t.Fatalf("decompressed output does not match input")
+	}
+	if exp := adler32.Checksum(src); adler != exp {
+		t.Errorf("decompress: adler32 %08x, expected %08x", adler, exp)
+	}
+}
+
+func TestCompressor(t *testing.T) {
+	c, err := NewCompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer c.Close()
+
+	// twice, to check that the reset compressor gives the same output as a new one
+	for i := 0; i < 2; i++ {
+		for _, in := range testInputs() {
+			dst := make([]byte, compressBound(len(in.data)))
+			n, adler, _, err := c.Compress(dst, in.data)
+			if err != nil {
+				t.Fatalf("%s: compress: %v", in.name, err)
+			}
+			if exp := adler32.Checksum(in.data); adler != exp {
+				t.Errorf("%s: compress: adler32 %08x, expected %08x", in.name, adler, exp)
+			}
+
+			ref := make([]byte, len(dst))
+			if m, _, _, err := compress(ref, in.data); err != nil {
+				t.Fatalf("%s: compress (new compressor): %v", in.name, err)
+			} else if !bytes.Equal(dst[:n], ref[:m]) {
+				t.Errorf("%s: output differs from a new compressor", in.name)
+			}
+			checkDecompress(t, dst[:n], in.data)
+		}
+	}
+}
+
+// TestCompressRuns pins the compressed size of zero-heavy inputs, since the
+// match finder has a shortcut for long runs which must find the same matches as
+// the binary tree.
+func TestCompressRuns(t *testing.T) {
+	for _, x := range []struct {
+		name string
+		data []byte
+		size int
+	}{
+		{"zeros-300000", make([]byte, 300000), 291},
+		{"zeros-1048576", make([]byte, 1<<20), 766},
+		{"zeros-3145733", make([]byte, 3<<20+5), 2088},
+		{"sparse-300000", testSparse(300000, 2), 16303},
+		{"sparse-1048576", testSparse(1<<20, 2), 54279},
+		{"sparse-3145733", testSparse(3<<20+5, 2), 159460},
+	} {
+		dst := make([]byte, compressBound(len(x.data)))
+		n, _, _, err := Compress(dst, x.data)
+		if err != nil {
+			t.Fatalf("%s: compress: %v", x.name, err)
+		}
+		if n != x.size {
+			t.Errorf("%s: compressed to %d bytes, expected %d", x.name, n, x.size)
+		}
+		checkDecompress(t, dst[:n], x.data)
+	}
+}
+
+// compressorCRC32 computes the CRC-32 returned by the compressor (and stored
+// at the end of the stream), which, like upstream LZHAM, is seeded with the
+// running Adler-32 after each block instead of the previous CRC.
+func compressorCRC32(b []byte) uint32 {
+	var a, c uint32 = 1, 0
+	for len(b) != 0 {
+		block := b[:min(len(b), ParallelBlockSize)]
+		s1, s2 := a&0xFFFF, a>>16
+		for _, x := range block {
+			s1 = (s1 + uint32(x)) % 65521
+			s2 = (s2 + s1) % 65521
+		}
+		a = s2<<16 | s1
+		c = crc32.Update(a, crc32.IEEETable, block)
+		b = b[len(block):]
+	}
+	return c
+}
+
+// TestCRC32 checks the CRC-32 computed while compressing (combined from the
+// CRC of each block) and decompressing (over the whole output), for every
+// length up to a few times the PCLMULQDQ fold size, and then lengths spanning
+// several blocks, at each alignment. The checksums don't depend on the level, so
+// it uses the fastest one.
+func TestCRC32(t *testing.T) {
+	c, err := NewCompressorLevel(LevelGreedy, 0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer c.Close()
+	d, err := NewDecompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer d.Close()
+
+	var lengths []int
+	for n := 1; n <= 1100; n++ {
+		lengths = append(lengths, n)
+	}
+	for n := 1100; n < 300000; n += n/16 + 1 {
+		lengths = append(lengths, n)
+	}
+	lengths = append(lengths, 8191, 8192, 8193, 65535, 65536, 65537, ParallelBlockSize, ParallelBlockSize+1, 300000)
+
+	data := testRandom(300000+2, 1)
+	comp := make([]byte, compressBound(len(data)))
+	dst := make([]byte, len(data))
+	for _, n := range lengths {
+		for off := 0; off <= 2; off++ {
+			src := data[off : off+n]
+
+			m, _, crc, err := c.Compress(comp, src)
+			if err != nil {
+				t.Fatalf("length %d, offset %d: compress: %v", n, off, err)
+			}
+			if exp := compressorCRC32(src); crc != exp {
+				t.Fatalf("length %d, offset %d: compress: crc32 %08x, expected %08x", n, off, crc, exp)
+			}
+
+			if _, _, crc, err := d.Decompress(dst[off:off+n], comp[:m]); err != nil {
+				t.Fatalf("length %d, offset %d: decompress: %v", n, off, err)
+			} else if exp := crc32.ChecksumIEEE(src); crc != exp {
+				t.Fatalf("length %d, offset %d: decompress: crc32 %08x, expected %08x", n, off, crc, exp)
+			}
+		}
+	}
+}
+
+func TestCompressorErrors(t *testing.T) {
+	c, err := NewCompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	src := testRecords(4<<10, 1)
+
+	if _, _, _, err := c.Compress(make([]byte, 16), src); err == nil {
+		t.Errorf("expected error for a small output buffer")
+	}
+	if _, _, _, err := c.Compress(nil, src); err == nil {
+		t.Errorf("expected error for a zero-length buffer")
+	}
+
+	// still usable after an error
+	dst := make([]byte, compressBound(len(src)))
+	if n, _, _, err := c.Compress(dst, src); err != nil {
+		t.Errorf("compress after error: %v", err)
+	} else {
+		checkDecompress(t, dst[:n], src)
+	}
+
+	c.Close()
+	c.Close()
+	if _, _, _, err := c.Compress(dst, src); err == nil {
+		t.Errorf("expected error for a closed compressor")
+	}
+}
+
+func TestDecompressor(t *testing.T) {
+	d, err := NewDecompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer d.Close()
+
+	for i := 0; i < 2; i++ {
+		for _, in := range testInputs() {
+			comp := make([]byte, compressBound(len(in.data)))
+			n, _, _, err := Compress(comp, in.data)
+			if err != nil {
+				t.Fatalf("%s: compress: %v", in.name, err)
+			}
+			comp = comp[:n]
+
+			dst := make([]byte, len(in.data))
+			n, adler, _, err := d.Decompress(dst, comp)
+			if err != nil {
+				t.Fatalf("%s: decompress: %v", in.name, err)
+			}
+			if !bytes.Equal(dst[:n], in.data) {
+				t.Fatalf("%s: decompressed output does not match input", in.name)
+			}
+			if exp := adler32.Checksum(in.data); adler != exp {
+				t.Errorf("%s: decompress: adler32 %08x, expected %08x", in.name, adler, exp)
+			}
+		}
+	}
+}
+
+func TestDecompressorErrors(t *testing.T) {
+	d, err := NewDecompressor()
+	if err != nil {
+		t.Fatal(err)
+	}
+	src := testRecords(64<<10, 1)
+	comp := make([]byte, compressBound(len(src)))
+	n, _, _, err := Compress(comp, src)
+	if err != nil {
+		t.Fatal(err)
+	}
+	comp = comp[:n]
+	dst := make([]byte, len(src))
+
+	if _, _, _, err := d.Decompress(dst[:len(dst)-1], comp); err == nil {
+		t.Errorf("expected error for a small output buffer")
+	}
+	if _, _, _, err := d.Decompress(dst, comp[:len(comp)/2]); err == nil {
+		t.Errorf("expected error for truncated input")
+	}
+	corrupt := append([]byte(nil), comp...)
+	corrupt[len(corrupt)/2] ^= 0xFF
+	if _, _, _, err := d.Decompress(dst, corrupt); err == nil {
+		t.Errorf("expected error for corrupted input")
+	}
+
+	// still usable after an error
+	if n, _, _, err := d.Decompress(dst, comp); err != nil {
+		t.Errorf("decompress after error: %v", err)
+	} else if !bytes.Equal(dst[:n], src) {
+		t.Errorf("decompressed output does not match input after error")
+	}
+
+	d.Close()
+	d.Close()
+	if _, _, _, err := d.Decompress(dst, comp); err == nil {
+		t.Errorf("expected error for a closed decompressor")
+	}
+}
+
+func TestCompressLevel(t *testing.T) {
+	for level := LevelFastest; level <= LevelGreedy; level++ {
+		for _, flags := range []Flags{0, FlagDeterministicParsing, FlagForcePolarCoding | FlagTradeoffDecompressionRate} {
+			c, err := NewCompressorLevel(level, flags)
+			if err != nil {
+				t.Fatalf("level %d flags %x: %v", level, flags, err)
+			}
+			for _, in := range testInputs() {
+				dst := make([]byte, compressBound(len(in.data)))
+				n, adler, _, err := CompressLevel(dst, in.data, level, flags)
+				if err != nil {
+					t.Fatalf("%s: level %d flags %x: compress: %v", in.name, level, flags, err)
+				}
+				if exp := adler32.Checksum(in.data); adler != exp {
+					t.Errorf("%s: level %d flags %x: adler32 %08x, expected %08x", in.name, level, flags, adler, exp)
+				}
+				checkDecompress(t, dst[:n], in.data)
+
+				// same as a compressor with the same level
+				ref := make([]byte, len(dst))
+				if m, _, _, err := c.Compress(ref, in.data); err != nil {
+					t.Fatalf("%s: level %d flags %x: compress (compressor): %v", in.name, level, flags, err)
+				} else if flags&FlagDeterministicParsing != 0 && !bytes.Equal(dst[:n], ref[:m]) {
+					t.Errorf("%s: level %d flags %x: output differs from NewCompressorLevel", in.name, level, flags)
+				}
+			}
+			c.Close()
+		}
+	}
+
+	// the defaults are the same as Compress
+	src := testRecords(300<<10, 1)
+	dst, ref := make([]byte, compressBound(len(src))), make([]byte, compressBound(len(src)))
+	n, _, _, err := CompressLevel(dst, src, LevelUber, FlagDeterministicParsing)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if m, _, _, err := Compress(ref, src); err != nil {
+		t.Fatal(err)
+	} else if !bytes.Equal(dst[:n], ref[:m]) {
+		t.Errorf("output differs from Compress")
+	}
+
+	// FlagExtremeParsing is slow, so only check it once
+	if n, _, _, err := CompressLevel(dst, src[:64<<10], LevelFastest, FlagExtremeParsing); err != nil {
+		t.Errorf("extreme parsing: %v", err)
+	} else {
+		checkDecompress(t, dst[:n], src[:64<<10])
+	}
+
+	for _, x := range []struct {
+		level Level
+		flags Flags
+	}{
+		{LevelGreedy + 1, 0},
+		{LevelUber, 1 << 5}, // LZHAM_COMP_FLAG_WRITE_ZLIB_STREAM, which changes the format
+	} {
+		if _, _, _, err := CompressLevel(dst, src, x.level, x.flags); err == nil {
+			t.Errorf("level %d flags %x: expected error for invalid level or flags", x.level, x.flags)
+		}
+		if _, err := NewCompressorLevel(x.level, x.flags); err == nil {
+			t.Errorf("level %d flags %x: expected error for invalid level or flags (compressor)", x.level, x.flags)
+		}
+	}
+}
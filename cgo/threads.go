@@ -0,0 +1,10 @@
+//go:build tf2lzhamthreads
+
+package tf2lzham
+
+// Build with the tf2lzhamthreads tag to use helper threads for match finding
+// during compression. The output is identical either way.
+
+// #cgo CXXFLAGS: -DLZHAM_THREADING=1
+// #cgo LDFLAGS: -pthread
+import "C"
@@ -0,0 +1,25 @@
+//go:build cgo
+
+package tf2lzham
+
+import tf2lzham "github.com/pg9182/tf2lzham/cgo"
+
+func init() {
+	backends = append(backends, backend{
+		Name:       "cgo",
+		Compress:   tf2lzham.Compress,
+		Decompress: tf2lzham.Decompress,
+		Levels: []benchLevel{
+			{"greedy", cgoCompressLevel(tf2lzham.LevelGreedy)},
+			{"fastest", cgoCompressLevel(tf2lzham.LevelFastest)},
+			{"uber", cgoCompressLevel(tf2lzham.LevelUber)},
+		},
+		CompressParallel: tf2lzham.CompressParallel,
+	})
+}
+
+func cgoCompressLevel(level tf2lzham.Level) func(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+	return func(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
+		return tf2lzham.CompressLevel(dst, src, level, 0)
+	}
+}
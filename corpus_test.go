@@ -0,0 +1,129 @@
+package tf2lzham
+
+import (
+	"encoding/binary"
+	"fmt"
+	"math"
+	"math/rand"
+	"sync"
+)
+
+// corpusEntry is a generated benchmark input.
+type corpusEntry struct {
+	Name string
+	Data []byte
+}
+
+// corpus returns the benchmark inputs, which are generated from fixed seeds on
+// first use so results are comparable between runs and releases without
+// bundling megabytes of test data in the repository.
+var corpus = sync.OnceValue(func() []corpusEntry {
+	var c []corpusEntry
+	for _, n := range []int{1 << 10, 16 << 10, 256 << 10} {
+		c = append(c, corpusEntry{"pdata-" + sizeName(n), pdata(n)})
+	}
+	for _, n := range []int{1 << 10, 64 << 10, 1 << 20} {
+		c = append(c, corpusEntry{"zeros-" + sizeName(n), sparse(n)})
+	}
+	for _, n := range []int{1 << 10, 64 << 10, 1 << 20} {
+		c = append(c, corpusEntry{"random-" + sizeName(n), random(n)})
+	}
+	for _, n := range []int{4 << 20, 16 << 20} {
+		c = append(c, corpusEntry{"asset-" + sizeName(n), asset(n)})
+	}
+	return c
+})
+
+func sizeName(n int) string {
+	if n >= 1<<20 {
+		return fmt.Sprintf("%dM", n>>20)
+	}
+	return fmt.Sprintf("%dK", n>>10)
+}
+
+var (
+	pdataNames   = []string{"pilot", "callsign", "loadout", "titan", "faction", "emblem", "banner", "skin"}
+	pdataWeapons = []string{"mp_weapon_r97", "mp_weapon_car", "mp_weapon_alternator_smg", "mp_weapon_rspn101", "mp_weapon_vinson", "mp_weapon_wingman", "mp_weapon_semipistol", "mp_weapon_frag_grenade", "mp_weapon_thermite_grenade", "mp_weapon_grenade_emp"}
+)
+
+// pdata generates records laid out like persistent player data: small
+// little-endian integers, flags, and fixed-size zero-padded strings.
+func pdata(n int) []byte {
+	r := rand.New(rand.NewSource(1))
+	b := make([]byte, 0, n+256)
+	for len(b) < n {
+		b = binary.LittleEndian.AppendUint32(b, uint32(r.Intn(1000000)))       // xp
+		b = binary.LittleEndian.AppendUint32(b, uint32(r.Intn(50)))            // gen
+		b = binary.LittleEndian.AppendUint16(b, uint16(r.Intn(1000)))          // kills
+		b = binary.LittleEndian.AppendUint16(b, uint16(r.Intn(1000)))          // deaths
+		b = binary.LittleEndian.AppendUint32(b, math.Float32bits(r.Float32())) // kd
+		for i := 0; i < 16; i++ {
+			b = append(b, byte(r.Intn(2))) // unlocks
+		}
+		b = appendFixed(b, pdataNames[r.Intn(len(pdataNames))], 32)
+		for i := 0; i < 3; i++ {
+			b = appendFixed(b, pdataWeapons[r.Intn(len(pdataWeapons))], 32)
+			b = binary.LittleEndian.AppendUint32(b, uint32(r.Intn(8))) // skin
+		}
+	}
+	return b[:n]
+}
+
+func appendFixed(b []byte, s string, n int) []byte {
+	b = append(b, s...)
+	return append(b, make([]byte, n-len(s))...)
+}
+
+// sparse generates mostly zero bytes with scattered values and short runs.
+func sparse(n int) []byte {
+	r := rand.New(rand.NewSource(2))
+	b := make([]byte, n)
+	for i := 0; i < n; i++ {
+		switch x := r.Intn(256); {
+		case x < 4:
+			b[i] = byte(r.Intn(256))
+		case x == 4:
+			v := byte(r.Intn(256))
+			for j := r.Intn(32); j > 0 && i < n; j-- {
+				b[i] = v
+				i++
+			}
+		}
+	}
+	return b
+}
+
+// random generates incompressible data.
+func random(n int) []byte {
+	b := make([]byte, n)
+	rand.New(rand.NewSource(3)).Read(b)
+	return b
+}
+
+// asset generates data resembling game assets: vertex buffers of slowly
+// varying floats, key/value text sections, and some noisy texture data.
+func asset(n int) []byte {
+	r := rand.New(rand.NewSource(4))
+	b := make([]byte, 0, n+64<<10)
+	for len(b) < n {
+		switch r.Intn(3) {
+		case 0:
+			x, y, z := r.Float32(), r.Float32(), r.Float32()
+			for i := r.Intn(4096); i > 0; i-- {
+				x, y, z = x+r.Float32()/64, y+r.Float32()/64, z+r.Float32()/64
+				b = binary.LittleEndian.AppendUint32(b, math.Float32bits(x))
+				b = binary.LittleEndian.AppendUint32(b, math.Float32bits(y))
+				b = binary.LittleEndian.AppendUint32(b, math.Float32bits(z))
+			}
+		case 1:
+			for i := r.Intn(512); i > 0; i-- {
+				b = fmt.Appendf(b, "\"%s\" \"%s_%d\"\n", pdataNames[r.Intn(len(pdataNames))], pdataWeapons[r.Intn(len(pdataWeapons))], r.Intn(64))
+			}
+		case 2:
+			for i := r.Intn(32 << 10); i > 0; i-- {
+				b = append(b, byte(r.Intn(16))<<4|byte(i&15))
+			}
+		}
+	}
+	return b[:n]
+}
@@ -0,0 +1,152 @@
+// Package parallel implements the backend-independent parts of
+// CompressParallel: splitting the input into chunks, running the workers, and
+// splicing the compressed chunks into a single stream.
+package parallel
+
+import (
+	"errors"
+	"hash/adler32"
+	"runtime"
+	"sync"
+	"sync/atomic"
+)
+
+// BlockSize is the block size used by the compressor for the TF2 dictionary
+// size. Chunks are rounded up to a multiple of it.
+const BlockSize = 128 << 10
+
+// chunk flags from lzham.h
+const (
+	ChunkFirst = 1 << 0
+	ChunkLast  = 1 << 1
+)
+
+// CompressFunc compresses an entire input.
+type CompressFunc func(dst, src []byte) (n int, adler32, crc32 uint32, err error)
+
+// ChunkFunc compresses a single chunk of a stream with the specified chunk
+// flags and the Adler-32 of the earlier chunks.
+type ChunkFunc func(dst, src []byte, flags, seed uint32) (n int, adler32, crc32 uint32, err error)
+
+// Compress splits src into chunks of chunkSize bytes (rounded up to a multiple
+// of BlockSize), compresses them on up to workers goroutines (GOMAXPROCS if
+// zero), and splices them into dst. If src fits in a single chunk, it is
+// compressed with compress instead. Each worker gets a ChunkFunc from
+// newWorker, and calls release (if not nil) when it's done.
+func Compress(dst, src []byte, chunkSize, workers int, compress CompressFunc, newWorker func() (fn ChunkFunc, release func(), err error)) (n int, adler32, crc32 uint32, err error) {
+	if chunkSize <= 0 || workers < 0 {
+		return 0, 0, 0, errors.New("lzham: invalid argument")
+	}
+	if chunkSize >= len(src) {
+		return compress(dst, src)
+	}
+	if chunkSize = (chunkSize + BlockSize - 1) / BlockSize * BlockSize; chunkSize >= len(src) {
+		return compress(dst, src)
+	}
+	if len(dst) == 0 {
+		return 0, 0, 0, errors.New("lzham: zero-length buffer")
+	}
+	if workers == 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	chunks := splitChunks(dst, src, chunkSize)
+	if workers > len(chunks) {
+		workers = len(chunks)
+	}
+
+	var (
+		wg   sync.WaitGroup
+		next atomic.Int32
+	)
+	take := func() *chunk {
+		if i := int(next.Add(1)) - 1; i < len(chunks) {
+			return &chunks[i]
+		}
+		return nil
+	}
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			fn, release, err := newWorker()
+			if err != nil {
+				for p := take(); p != nil; p = take() {
+					p.err = err
+				}
+				return
+			}
+			if release != nil {
+				defer release()
+			}
+			for p := take(); p != nil; p = take() {
+				p.compress(fn, src)
+			}
+		}()
+	}
+	wg.Wait()
+
+	return spliceChunks(dst, chunks)
+}
+
+// chunk is a chunk of the input.
+type chunk struct {
+	src     []byte
+	dst     []byte // the start of the final output for the first chunk
+	flags   uint32
+	offset  int // of src in the input
+	n       int
+	adler32 uint32
+	crc32   uint32
+	err     error
+}
+
+// splitChunks splits src into chunks. The first chunk is compressed directly
+// into dst, and the others into their own buffers, which are large enough for
+// the worst case (each block is stored if it doesn't compress).
+func splitChunks(dst, src []byte, chunkSize int) []chunk {
+	chunks := make([]chunk, (len(src)+chunkSize-1)/chunkSize)
+	for i := range chunks {
+		c := &chunks[i]
+		c.offset = i * chunkSize
+		c.src = src[c.offset:min(c.offset+chunkSize, len(src))]
+		if i == 0 {
+			c.dst = dst
+			c.flags |= ChunkFirst
+		} else {
+			c.dst = make([]byte, len(c.src)+len(c.src)/1024+64)
+		}
+		if i == len(chunks)-1 {
+			c.flags |= ChunkLast
+		}
+	}
+	return chunks
+}
+
+// compress compresses the chunk of input. The final block written by the last
+// chunk needs the checksum of the entire input, so it also checksums the data
+// before it.
+func (p *chunk) compress(fn ChunkFunc, input []byte) {
+	var seed uint32
+	if p.flags&ChunkLast != 0 {
+		seed = adler32.Checksum(input[:p.offset])
+	}
+	p.n, p.adler32, p.crc32, p.err = fn(p.dst, p.src, p.flags, seed)
+}
+
+// spliceChunks copies the compressed chunks after the first one in dst.
+func spliceChunks(dst []byte, chunks []chunk) (n int, adler32, crc32 uint32, err error) {
+	for i, c := range chunks {
+		if c.err != nil {
+			return 0, 0, 0, c.err
+		}
+		if i != 0 {
+			if n+c.n > len(dst) {
+				return 0, 0, 0, errors.New("lzham: output buffer too small")
+			}
+			copy(dst[n:], c.dst[:c.n])
+		}
+		n += c.n
+	}
+	last := chunks[len(chunks)-1]
+	return n, last.adler32, last.crc32, nil
+}
@@ -2,7 +2,11 @@
 
 package tf2lzham
 
-import tf2lzham "github.com/pg9182/tf2lzham/cgo"
+import (
+	"io"
+
+	tf2lzham "github.com/pg9182/tf2lzham/cgo"
+)
 
 const WebAssembly = false
 
@@ -13,3 +17,54 @@ func Decompress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
 func Compress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
 	return tf2lzham.Compress(dst, src)
 }
+
+type (
+	Level = tf2lzham.Level
+	Flags = tf2lzham.Flags
+)
+
+const (
+	LevelFastest = tf2lzham.LevelFastest
+	LevelFaster  = tf2lzham.LevelFaster
+	LevelDefault = tf2lzham.LevelDefault
+	LevelBetter  = tf2lzham.LevelBetter
+	LevelUber    = tf2lzham.LevelUber
+	LevelGreedy  = tf2lzham.LevelGreedy
+
+	FlagForcePolarCoding          = tf2lzham.FlagForcePolarCoding
+	FlagExtremeParsing            = tf2lzham.FlagExtremeParsing
+	FlagDeterministicParsing      = tf2lzham.FlagDeterministicParsing
+	FlagTradeoffDecompressionRate = tf2lzham.FlagTradeoffDecompressionRate
+)
+
+func CompressLevel(dst, src []byte, level Level, flags Flags) (n int, adler32, crc32 uint32, err error) {
+	return tf2lzham.CompressLevel(dst, src, level, flags)
+}
+
+const ParallelBlockSize = tf2lzham.ParallelBlockSize
+
+func CompressParallel(dst, src []byte, chunkSize, workers int) (n int, adler32, crc32 uint32, err error) {
+	return tf2lzham.CompressParallel(dst, src, chunkSize, workers)
+}
+
+type (
+	BatchResult = tf2lzham.BatchResult
+	Reader      = tf2lzham.Reader
+	Writer      = tf2lzham.Writer
+)
+
+func CompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	return tf2lzham.CompressBatch(dst, src)
+}
+
+func DecompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	return tf2lzham.DecompressBatch(dst, src)
+}
+
+func NewReader(r io.Reader) (*Reader, error) {
+	return tf2lzham.NewReader(r)
+}
+
+func NewWriter(w io.Writer) (*Writer, error) {
+	return tf2lzham.NewWriter(w)
+}
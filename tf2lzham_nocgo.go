@@ -13,3 +13,19 @@ func Decompress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
 func Compress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
 	return tf2lzham.Compress(dst, src)
 }
+
+const ParallelBlockSize = tf2lzham.ParallelBlockSize
+
+func CompressParallel(dst, src []byte, chunkSize, workers int) (n int, adler32, crc32 uint32, err error) {
+	return tf2lzham.CompressParallel(dst, src, chunkSize, workers)
+}
+
+type BatchResult = tf2lzham.BatchResult
+
+func CompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	return tf2lzham.CompressBatch(dst, src)
+}
+
+func DecompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	return tf2lzham.DecompressBatch(dst, src)
+}
@@ -0,0 +1,71 @@
+package tf2zham
+
+import (
+	"context"
+	"errors"
+)
+
+// BatchResult is the result of compressing or decompressing a single buffer in
+// a batch.
+type BatchResult struct {
+	N       int
+	Adler32 uint32
+	CRC32   uint32
+	Err     error
+}
+
+// CompressBatch compresses each src[i] into dst[i]. It is equivalent to calling
+// Compress for each buffer, but uses a single instance for the whole batch. An
+// error is only returned if the batch itself is invalid; errors for individual
+// buffers are returned in the results.
+func CompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	return executeBatch(dst, src, "compress")
+}
+
+// DecompressBatch decompresses each src[i] into dst[i]. It is equivalent to
+// calling Decompress for each buffer, but uses a single instance for the whole
+// batch. An error is only returned if the batch itself is invalid; errors for
+// individual buffers are returned in the results.
+func DecompressBatch(dst, src [][]byte) ([]BatchResult, error) {
+	return executeBatch(dst, src, "decompress")
+}
+
+func executeBatch(dst, src [][]byte, method string) ([]BatchResult, error) {
+	if len(dst) != len(src) {
+		return nil, errors.New("lzham: mismatched batch length")
+	}
+	if len(src) == 0 {
+		return nil, nil
+	}
+	ctx := context.Background()
+
+	inst, err := getInstance(ctx)
+	if err != nil {
+		return nil, err
+	}
+	res := make([]BatchResult, len(src))
+	for i := range src {
+		if len(dst[i]) == 0 || len(src[i]) == 0 {
+			res[i].Err = errors.New("lzham: zero-length buffer")
+			continue
+		}
+		var (
+			r  = &res[i]
+			ok bool
+		)
+		r.N, r.Adler32, r.CRC32, ok, r.Err = inst.execute(ctx, dst[i], src[i], method, method)
+		if !ok {
+			// the instance can't be reused, so replace it for the rest of the
+			// batch
+			putInstance(ctx, inst, false)
+			if inst, err = getInstance(ctx); err != nil {
+				for i++; i < len(src); i++ {
+					res[i].Err = err
+				}
+				return res, nil
+			}
+		}
+	}
+	putInstance(ctx, inst, true)
+	return res, nil
+}
@@ -0,0 +1,39 @@
+package tf2zham
+
+import (
+	"errors"
+	"fmt"
+
+	"github.com/pg9182/tf2lzham/internal/parallel"
+)
+
+// ParallelBlockSize is the block size used by the compressor for the TF2
+// dictionary size. CompressParallel rounds chunks up to a multiple of it.
+const ParallelBlockSize = parallel.BlockSize
+
+// CompressParallel is like Compress, but splits src into chunks of chunkSize
+// bytes (rounded up to a multiple of ParallelBlockSize), compresses them in up
+// to workers instances (GOMAXPROCS if zero), and splices them into a single
+// stream. Since each chunk starts with fresh models and can't reference earlier
+// chunks, the ratio is worse than Compress, but the output can still be
+// decompressed by Decompress (or the game). If src fits in a single chunk, it
+// is equivalent to Compress.
+//
+// It needs the tf2lzham_compress_chunk export, which the embedded module
+// predates. Until the module is regenerated with go generate, it returns an
+// error wrapping errors.ErrUnsupported for any input.
+func CompressParallel(dst, src []byte, chunkSize, workers int) (n int, adler32, crc32 uint32, err error) {
+	if !exported("tf2lzham_compress_chunk") {
+		return 0, 0, 0, fmt.Errorf("lzham: CompressParallel is not supported by the embedded module: %w", errors.ErrUnsupported)
+	}
+	return parallel.Compress(dst, src, chunkSize, workers, Compress, func() (parallel.ChunkFunc, func(), error) {
+		// each chunk takes an instance from the pool
+		return compressChunk, nil, nil
+	})
+}
+
+// compressChunk compresses a single chunk of a stream with the specified chunk
+// flags and the Adler-32 of the earlier chunks.
+func compressChunk(dst, src []byte, flags, seed uint32) (n int, adler32, crc32 uint32, err error) {
+	return execute(dst, src, "compress_chunk", "compress", uint64(flags), uint64(seed))
+}
@@ -0,0 +1,52 @@
+package tf2zham
+
+import (
+	"bytes"
+	"errors"
+	"hash/adler32"
+	"testing"
+)
+
+func TestCompressParallel(t *testing.T) {
+	src := testRecords(700<<10+5, 1)
+
+	if !exported("tf2lzham_compress_chunk") {
+		// fails clearly, even if it would only need Compress
+		comp := make([]byte, len(src)+len(src)/1024+128)
+		for _, n := range []int{len(src), 4 << 10} {
+			if _, _, _, err := CompressParallel(comp, src[:n], ParallelBlockSize, 0); !errors.Is(err, errors.ErrUnsupported) {
+				t.Errorf("%d bytes: expected ErrUnsupported without tf2lzham_compress_chunk, got %v", n, err)
+			}
+		}
+		return
+	}
+	for _, x := range []struct{ chunkSize, workers int }{
+		{ParallelBlockSize, 1},
+		{ParallelBlockSize, 3},
+		{256 << 10, 0},
+	} {
+		comp := make([]byte, len(src)+len(src)/1024+128)
+		n, adler, _, err := CompressParallel(comp, src, x.chunkSize, x.workers)
+		if err != nil {
+			t.Fatalf("chunk size %d, %d workers: compress: %v", x.chunkSize, x.workers, err)
+		}
+		if exp := adler32.Checksum(src); adler != exp {
+			t.Errorf("chunk size %d, %d workers: adler32 %08x, expected %08x", x.chunkSize, x.workers, adler, exp)
+		}
+		dst := make([]byte, len(src))
+		if n, _, _, err = Decompress(dst, comp[:n]); err != nil {
+			t.Fatalf("chunk size %d, %d workers: decompress: %v", x.chunkSize, x.workers, err)
+		}
+		if !bytes.Equal(dst[:n], src) {
+			t.Fatalf("chunk size %d, %d workers: decompressed output does not match input", x.chunkSize, x.workers)
+		}
+	}
+
+	comp := make([]byte, len(src)+len(src)/1024+128)
+	if _, _, _, err := CompressParallel(comp, src, 0, 0); err == nil {
+		t.Errorf("expected error for an invalid chunk size")
+	}
+	if _, _, _, err := CompressParallel(comp[:len(comp)/8], src, ParallelBlockSize, 0); err == nil {
+		t.Errorf("expected error for a small output buffer")
+	}
+}
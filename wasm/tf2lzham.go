@@ -6,13 +6,16 @@ import (
 	_ "embed"
 	"errors"
 	"fmt"
+	goruntime "runtime"
 	"sync"
+	"sync/atomic"
 
 	"github.com/tetratelabs/wazero"
+	"github.com/tetratelabs/wazero/api"
 	"github.com/tetratelabs/wazero/imports/wasi_snapshot_preview1"
 )
 
-//go:generate sh -c "docker run --rm -i -v \"$(pwd)/..:/src\" -w /src -u $(id -u):$(id -g) ghcr.io/webassembly/wasi-sdk:wasi-sdk-21 sh -euxc '${DOLLAR}CXX ${DOLLAR}CXXFLAGS -g -nostartfiles -std=c++11 -DLZHAM_ANSI_CPLUSPLUS -DNDEBUG -Oz -Wall -Wno-unused-value -fno-exceptions -ffast-math cgo/*.cpp -Wl,--no-entry -Wl,--export-dynamic -o wasm/tf2lzham.wasm'"
+//go:generate sh -c "docker run --rm -i -v \"$(pwd)/..:/src\" -w /src -u $(id -u):$(id -g) ghcr.io/webassembly/wasi-sdk:wasi-sdk-21 sh -euxc '${DOLLAR}CXX ${DOLLAR}CXXFLAGS -g -nostartfiles -std=c++11 -DLZHAM_ANSI_CPLUSPLUS -DNDEBUG -Oz -Wall -Wno-unused-value -fno-exceptions -ffast-math -msimd128 cgo/*.cpp -Wl,--no-entry -Wl,--export-dynamic -o wasm/tf2lzham.wasm'"
 //go:embed tf2lzham.wasm
 var wasm []byte
 
@@ -20,6 +23,7 @@ var (
 	compile sync.Once
 	runtime wazero.Runtime
 	module  wazero.CompiledModule
+	exports map[string]api.FunctionDefinition
 )
 
 func EnsureCompiled() {
@@ -37,45 +41,164 @@ func EnsureCompiled() {
 		if err != nil {
 			panic(fmt.Errorf("tf2lzham/wasm: failed to compile module: %w", err))
 		}
+		exports = module.ExportedFunctions()
 	})
 }
 
-func execute(dst, src []byte, decompress bool) (int, uint32, uint32, error) {
-	if len(dst) == 0 || len(src) == 0 {
-		return 0, 0, 0, errors.New("lzham: zero-length buffer")
+// exported checks whether the embedded module exports all of the named
+// functions. Functions added after the module was last built with go generate
+// won't be.
+func exported(names ...string) bool {
+	EnsureCompiled()
+	for _, name := range names {
+		if _, ok := exports[name]; !ok {
+			return false
+		}
 	}
-	ctx := context.Background()
+	return true
+}
 
-	var method string
-	if decompress {
-		method = "decompress"
-	} else {
-		method = "compress"
+// DefaultMaxMemory is the default linear memory size above which an instance
+// is closed after use instead of being returned to the pool. The compressor
+// needs about 116 MiB for the TF2 dictionary size, so this allows instances
+// to be reused for compressing inputs up to a few MiB.
+const DefaultMaxMemory = 128 << 20
+
+var (
+	poolMaxIdle   atomic.Int32
+	poolMaxMemory atomic.Uint32
+	poolMu        sync.Mutex
+	poolIdle      []*instance
+)
+
+func init() {
+	poolMaxIdle.Store(int32(goruntime.GOMAXPROCS(0)))
+	poolMaxMemory.Store(DefaultMaxMemory)
+}
+
+// SetPoolLimits sets the maximum number of idle instances kept for reuse, and
+// the linear memory size (in bytes) above which an instance is closed after use
+// instead of being reused. WebAssembly memory cannot shrink, so this bounds the
+// memory held by idle instances. If maxIdle is zero or negative, instances are
+// not reused.
+func SetPoolLimits(maxIdle int, maxMemory uint32) {
+	if maxIdle < 0 {
+		maxIdle = 0
+	}
+	poolMaxIdle.Store(int32(maxIdle))
+	poolMaxMemory.Store(maxMemory)
+
+	poolMu.Lock()
+	var closed []*instance
+	if n := len(poolIdle) - maxIdle; n > 0 {
+		closed = append(closed, poolIdle[:n]...)
+		poolIdle = append(poolIdle[:0], poolIdle[n:]...)
 	}
+	poolMu.Unlock()
+
+	for _, inst := range closed {
+		inst.mod.Close(context.Background())
+	}
+}
+
+// instance is an instantiated module. It must only be used by one goroutine at
+// a time.
+type instance struct {
+	mod    api.Module
+	malloc api.Function
+	free   api.Function // nil if the module doesn't support reuse
+}
+
+func getInstance(ctx context.Context) (*instance, error) {
+	poolMu.Lock()
+	if n := len(poolIdle); n != 0 {
+		inst := poolIdle[n-1]
+		poolIdle[n-1] = nil
+		poolIdle = poolIdle[:n-1]
+		poolMu.Unlock()
+		return inst, nil
+	}
+	poolMu.Unlock()
 
 	EnsureCompiled()
 
-	// we cannot use an instantiated module concurrently
-	// - we grow the instantiated memory to fit the buffer
-	// - if we use a pool, we may leak memory
-	// - instantiation is fast enough (a few hundred microseconds)
-	// - so instantiate it for every call
-	instance, err := runtime.InstantiateModule(ctx, module, wazero.NewModuleConfig().WithName(""))
+	mod, err := runtime.InstantiateModule(ctx, module, wazero.NewModuleConfig().WithName(""))
+	if err != nil {
+		return nil, err
+	}
+	inst := &instance{
+		mod:    mod,
+		malloc: mod.ExportedFunction("tf2lzham_malloc"),
+		free:   mod.ExportedFunction("tf2lzham_free"),
+	}
+	if inst.free == nil {
+		// tf2lzham_malloc uses operator new, so buffers can also be freed
+		// with operator delete in modules built before tf2lzham_free (which
+		// includes the embedded one until it is regenerated)
+		inst.free = mod.ExportedFunction("_ZdlPv")
+	}
+	if inst.malloc == nil {
+		mod.Close(ctx)
+		return nil, fmt.Errorf("wasm: missing expected symbol")
+	}
+	return inst, nil
+}
+
+// putInstance returns an instance to the pool if it can be safely reused. An
+// instance which trapped, or which doesn't export a way to free buffers, may
+// have leaked memory, so it is closed instead.
+func putInstance(ctx context.Context, inst *instance, ok bool) {
+	if ok && inst.free != nil && inst.mod.Memory().Size() <= poolMaxMemory.Load() {
+		poolMu.Lock()
+		if len(poolIdle) < int(poolMaxIdle.Load()) {
+			poolIdle = append(poolIdle, inst)
+			poolMu.Unlock()
+			return
+		}
+		poolMu.Unlock()
+	}
+	inst.mod.Close(ctx)
+}
+
+// execute runs fn (tf2lzham_compress, tf2lzham_compress_chunk, or
+// tf2lzham_decompress) in a pooled instance. See instance.execute.
+func execute(dst, src []byte, fn, method string, args ...uint64) (int, uint32, uint32, error) {
+	if len(dst) == 0 || len(src) == 0 {
+		return 0, 0, 0, errors.New("lzham: zero-length buffer")
+	}
+	if !exported("tf2lzham_"+fn, "tf2lzham_"+method+"_strerror") {
+		return 0, 0, 0, fmt.Errorf("wasm: missing expected symbol tf2lzham_%s: %w", fn, errors.ErrUnsupported)
+	}
+	ctx := context.Background()
+
+	// instances are pooled, but each one is only used by a single call at a
+	// time since we grow the instantiated memory to fit the buffer
+	inst, err := getInstance(ctx)
 	if err != nil {
 		return 0, 0, 0, err
 	}
-	defer instance.Close(ctx)
+	n, adler32, crc32, ok, err := inst.execute(ctx, dst, src, fn, method, args...)
+	putInstance(ctx, inst, ok)
+	return n, adler32, crc32, err
+}
 
+// execute runs the specified function, passing any additional arguments after
+// the checksum pointers, and converts the status using the strerror function
+// for method (compress or decompress). If the returned bool is false, the
+// instance is in an unknown state and must not be reused.
+func (inst *instance) execute(ctx context.Context, dst, src []byte, fn, method string, args ...uint64) (int, uint32, uint32, bool, error) {
 	var (
-		malloc   = instance.ExportedFunction("tf2lzham_malloc")
-		compress = instance.ExportedFunction("tf2lzham_" + method)
-		strerror = instance.ExportedFunction("tf2lzham_" + method + "_strerror")
+		malloc   = inst.malloc
+		free     = inst.free
+		compress = inst.mod.ExportedFunction("tf2lzham_" + fn)
+		strerror = inst.mod.ExportedFunction("tf2lzham_" + method + "_strerror")
 	)
-	if malloc == nil || compress == nil || strerror == nil {
-		return 0, 0, 0, fmt.Errorf("wasm: missing expected symbol")
+	if compress == nil || strerror == nil {
+		// nothing was called, so the instance is unchanged
+		return 0, 0, 0, true, fmt.Errorf("wasm: missing expected symbol tf2lzham_%s: %w", fn, errors.ErrUnsupported)
 	}
 
-	mem := instance.Memory()
+	mem := inst.mod.Memory()
 
 	var (
 		lenLen = uint32(32 / 4)
@@ -87,7 +210,7 @@ func execute(dst, src []byte, decompress bool) (int, uint32, uint32, error) {
 
 	var ptr uint32
 	if r, err := malloc.Call(ctx, uint64(lenLen+adlLen+crcLen+dstLen+srcLen)); err != nil {
-		return 0, 0, 0, err
+		return 0, 0, 0, false, err
 	} else {
 		ptr = uint32(r[0])
 	}
@@ -104,35 +227,63 @@ func execute(dst, src []byte, decompress bool) (int, uint32, uint32, error) {
 	mem.WriteUint32Le(crcOff, 0)
 	mem.Write(srcOff, src)
 
-	if r, err := compress.Call(ctx, uint64(dstOff), uint64(lenOff), uint64(srcOff), uint64(srcLen), uint64(adlOff), uint64(crcOff)); err != nil {
-		return 0, 0, 0, err
-	} else if r, err := strerror.Call(ctx, r[0]); err != nil {
-		return 0, 0, 0, err
-	} else if ptr := uint32(r[0]); ptr != 0 {
-		b, _ := instance.Memory().Read(ptr, 128)
+	var (
+		n       int
+		adler32 uint32
+		crc32   uint32
+		status  error
+	)
+	if r, err := compress.Call(ctx, append([]uint64{uint64(dstOff), uint64(lenOff), uint64(srcOff), uint64(srcLen), uint64(adlOff), uint64(crcOff)}, args...)...); err != nil {
+		return 0, 0, 0, false, err
+	} else if msg, err := inst.strerror(ctx, strerror, r[0]); err != nil {
+		return 0, 0, 0, false, err
+	} else if msg != "" {
+		status = errors.New(msg)
+	} else {
+		var (
+			lenVal, _ = mem.ReadUint32Le(lenOff)
+			dstMem, _ = mem.Read(dstOff, lenVal)
+		)
+		adler32, _ = mem.ReadUint32Le(adlOff)
+		crc32, _ = mem.ReadUint32Le(crcOff)
+		n = int(lenVal)
+		copy(dst, dstMem)
+	}
+
+	// the rest of the heap is freed by lzham before returning, so releasing
+	// the buffer returns the instance to its initial (but possibly grown) state
+	if free == nil {
+		return n, adler32, crc32, false, status
+	}
+	if _, err := free.Call(ctx, uint64(ptr)); err != nil {
+		return n, adler32, crc32, false, status
+	}
+	return n, adler32, crc32, true, status
+}
+
+// strerror converts a status code into a message using the specified strerror
+// function. The message is empty if the status indicates success.
+func (inst *instance) strerror(ctx context.Context, strerror api.Function, status uint64) (string, error) {
+	r, err := strerror.Call(ctx, status)
+	if err != nil {
+		return "", err
+	}
+	if ptr := uint32(r[0]); ptr != 0 {
+		b, _ := inst.mod.Memory().Read(ptr, 128)
 		if n := bytes.IndexByte(b, 0); n != -1 {
 			b = b[:n]
 		} else {
-			return 0, 0, 0, fmt.Errorf("wasm: strerror returned an invalid string")
+			return "", fmt.Errorf("wasm: strerror returned an invalid string")
 		}
-		return 0, 0, 0, errors.New(string(b))
+		return string(b), nil
 	}
-
-	var (
-		adler32, _ = mem.ReadUint32Le(adlOff)
-		crc32, _   = mem.ReadUint32Le(crcOff)
-		lenVal, _  = mem.ReadUint32Le(lenOff)
-		dstMem, _  = mem.Read(dstOff, lenVal)
-	)
-	copy(dst, dstMem)
-
-	return int(lenVal), adler32, crc32, nil
+	return "", nil
 }
 
 func Decompress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
-	return execute(dst, src, true)
+	return execute(dst, src, "decompress", "decompress")
 }
 
 func Compress(dst, src []byte) (n int, adler32, crc32 uint32, err error) {
-	return execute(dst, src, false)
+	return execute(dst, src, "compress", "compress")
 }
@@ -0,0 +1,133 @@
+package tf2zham
+
+import (
+	"bytes"
+	"context"
+	"errors"
+	"math/rand"
+	goruntime "runtime"
+	"testing"
+)
+
+// testRecords generates compressible fixed-size records.
+func testRecords(n int, seed int64) []byte {
+	r := rand.New(rand.NewSource(seed))
+	names := []string{"mp_weapon_r97", "mp_weapon_car", "mp_weapon_wingman", "mp_titanweapon_xo16"}
+	b := make([]byte, 0, n+64)
+	for len(b) < n {
+		b = append(b, byte(r.Intn(256)), byte(r.Intn(16)))
+		b = append(b, names[r.Intn(len(names))]...)
+		b = append(b, make([]byte, 24)...)
+	}
+	return b[:n]
+}
+
+func roundTrip(t *testing.T, src []byte) {
+	t.Helper()
+	comp := make([]byte, len(src)+len(src)/1024+128)
+	n, _, _, err := Compress(comp, src)
+	if err != nil {
+		t.Fatalf("compress: %v", err)
+	}
+	dst := make([]byte, len(src))
+	if n, _, _, err = Decompress(dst, comp[:n]); err != nil {
+		t.Fatalf("decompress: %v", err)
+	}
+	if !bytes.Equal(dst[:n], src) {
+		t.Fatalf("decompressed output does not match input")
+	}
+}
+
+func idleInstances() []*instance {
+	poolMu.Lock()
+	defer poolMu.Unlock()
+	return append([]*instance(nil), poolIdle...)
+}
+
+func TestPool(t *testing.T) {
+	SetPoolLimits(1, DefaultMaxMemory)
+	defer SetPoolLimits(goruntime.GOMAXPROCS(0), DefaultMaxMemory)
+
+	roundTrip(t, testRecords(256<<10, 1))
+	idle := idleInstances()
+	if len(idle) != 1 {
+		t.Fatalf("expected 1 idle instance, got %d", len(idle))
+	}
+	if idle[0].free == nil {
+		t.Fatalf("module doesn't export a free function")
+	}
+
+	// the same instance should be reused without growing its memory
+	size := idle[0].mod.Memory().Size()
+	for i := 0; i < 4; i++ {
+		roundTrip(t, testRecords(256<<10, int64(i)))
+	}
+	if now := idleInstances(); len(now) != 1 || now[0] != idle[0] {
+		t.Errorf("instance was not reused")
+	} else if now := idle[0].mod.Memory().Size(); now != size {
+		t.Errorf("memory grew from %d to %d bytes", size, now)
+	}
+
+	// instances above the memory limit are closed
+	SetPoolLimits(1, 1)
+	roundTrip(t, testRecords(4<<10, 1))
+	if n := len(idleInstances()); n != 0 {
+		t.Errorf("expected instance above the memory limit to be closed, got %d", n)
+	}
+
+	// not reused if disabled
+	SetPoolLimits(0, DefaultMaxMemory)
+	roundTrip(t, testRecords(4<<10, 1))
+	if n := len(idleInstances()); n != 0 {
+		t.Errorf("expected no idle instances, got %d", n)
+	}
+
+	// negative limits also disable reuse, and release existing instances
+	SetPoolLimits(1, DefaultMaxMemory)
+	roundTrip(t, testRecords(4<<10, 1))
+	SetPoolLimits(-1, DefaultMaxMemory)
+	if n := len(idleInstances()); n != 0 {
+		t.Errorf("expected no idle instances, got %d", n)
+	}
+	SetPoolLimits(-1, DefaultMaxMemory)
+	roundTrip(t, testRecords(4<<10, 1))
+	if n := len(idleInstances()); n != 0 {
+		t.Errorf("expected no idle instances, got %d", n)
+	}
+}
+
+// A function missing from the embedded module fails without instantiating or
+// discarding an instance.
+func TestMissingExport(t *testing.T) {
+	SetPoolLimits(1, DefaultMaxMemory)
+	defer SetPoolLimits(goruntime.GOMAXPROCS(0), DefaultMaxMemory)
+
+	roundTrip(t, testRecords(4<<10, 1))
+	idle := idleInstances()
+	if len(idle) != 1 {
+		t.Fatalf("expected 1 idle instance, got %d", len(idle))
+	}
+
+	src := testRecords(4<<10, 1)
+	dst := make([]byte, len(src)*2)
+	if _, _, _, err := execute(dst, src, "missing", "compress"); !errors.Is(err, errors.ErrUnsupported) {
+		t.Errorf("expected ErrUnsupported, got %v", err)
+	}
+	if now := idleInstances(); len(now) != 1 || now[0] != idle[0] {
+		t.Errorf("instance was not kept")
+	}
+
+	ctx := context.Background()
+	inst, err := getInstance(ctx)
+	if err != nil {
+		t.Fatal(err)
+	}
+	_, _, _, ok, err := inst.execute(ctx, dst, src, "missing", "compress")
+	putInstance(ctx, inst, ok)
+	if !errors.Is(err, errors.ErrUnsupported) {
+		t.Errorf("expected ErrUnsupported, got %v", err)
+	}
+	if !ok {
+		t.Errorf("expected the instance to be reusable")
+	}
+}
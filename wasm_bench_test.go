@@ -0,0 +1,13 @@
+package tf2lzham
+
+import tf2zham "github.com/pg9182/tf2lzham/wasm"
+
+func init() {
+	// the embedded module doesn't export the functions for CompressLevel or
+	// CompressParallel
+	backends = append(backends, backend{
+		Name:       "wasm",
+		Compress:   tf2zham.Compress,
+		Decompress: tf2zham.Decompress,
+	})
+}